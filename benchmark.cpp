@@ -0,0 +1,159 @@
+// Scaling benchmark: instructions/sec of the RR scheduler versus num-cpu.
+//
+// Build: g++ -std=c++17 -O2 -pthread benchmark.cpp -o os_benchmark
+// Usage: ./os_benchmark [--max-cores N] [--processes N] [--instructions N]
+//                       [--scheduler rr|fcfs|priority|sjf|mlfq] [--delay MS]
+//
+// Runs the real cpuWorker loop (delay-per-exec 0 unless --delay is given) on
+// the same set of generated programs for 1..N cores and reports throughput
+// and speedup.
+
+#define CSOPESY_NO_MAIN
+#include "main.cpp"
+
+#include <filesystem>
+
+struct BenchmarkResult
+{
+    int cores = 0;
+    long long instructions = 0;
+    double seconds = 0;
+};
+
+BenchmarkResult runScalingPass(int cores, const std::vector<std::shared_ptr<const Program>> &programs)
+{
+    CPU_CORES = cores;
+    initializeMemorySystem();
+
+    std::deque<ExecutableScreen> procs;
+    long long instructions = 0;
+    for (size_t i = 0; i < programs.size(); ++i)
+    {
+        ExecutableScreen proc = createScreen("bench" + std::to_string(i + 1));
+        loadProgram(proc, programs[i]);
+        if (!allocateProcessMemory(proc, MIN_MEM_PER_PROC))
+        {
+            std::cerr << "Benchmark: memory allocation failed for " << proc.name << "\n";
+            continue;
+        }
+        instructions += proc.totalLines;
+        procs.push_back(std::move(proc));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopScheduler = false;
+    }
+    for (auto &proc : procs)
+        enqueueReady(&proc);
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < cores; ++i)
+        workers.emplace_back(cpuWorker, i);
+    cv.notify_all();
+
+    // Done once every process has exited; finishedTime is set last on the exit path
+    while (true)
+    {
+        bool allDone = true;
+        for (const auto &proc : procs)
+        {
+            std::lock_guard<CopyableMutex> stateLock(proc.stateMutex);
+            if (proc.finishedTime.empty())
+            {
+                allDone = false;
+                break;
+            }
+        }
+        if (allDone)
+            break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopScheduler = true;
+    }
+    cv.notify_all();
+    for (auto &t : workers)
+        t.join();
+    for (int i = 0; i < cores; ++i)
+        activePerCore[i] = nullptr;
+
+    BenchmarkResult result;
+    result.cores = cores;
+    result.instructions = instructions;
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    int maxCores = static_cast<int>(std::thread::hardware_concurrency());
+    int processCount = 64;
+    int instructionsPerProcess = 2000;
+    int delay = 0;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        if (arg == "--max-cores")
+            maxCores = std::stoi(argv[i + 1]);
+        else if (arg == "--processes")
+            processCount = std::stoi(argv[i + 1]);
+        else if (arg == "--instructions")
+            instructionsPerProcess = std::stoi(argv[i + 1]);
+        else if (arg == "--delay")
+            delay = std::stoi(argv[i + 1]);
+        else if (arg == "--scheduler")
+            schedulerPolicy = makeSchedulerPolicy(argv[i + 1]);
+    }
+    maxCores = std::max(1, std::min(maxCores, 128));
+
+    // Process logs, memory stamps and the swap file go to a scratch directory
+    std::filesystem::path workDir = std::filesystem::temp_directory_path() / "csopesy-benchmark";
+    std::filesystem::remove_all(workDir);
+    std::filesystem::create_directories(workDir);
+    std::filesystem::current_path(workDir);
+    output_dir = workDir.string();
+
+    delayPerExec = delay;
+    quantum = 5;
+    MEM_TOTAL = std::max(MEM_TOTAL, processCount * MIN_MEM_PER_PROC);
+
+    // Every pass runs the same programs so only the core count changes
+    std::vector<std::shared_ptr<const Program>> programs;
+    for (int i = 0; i < processCount; ++i)
+        programs.push_back(std::make_shared<const Program>(compileProgram(generateRandomInstructions(instructionsPerProcess))));
+
+    std::cout << "Scheduler: " << schedulerPolicy->name() << ", processes: " << processCount
+              << ", instructions/process: " << instructionsPerProcess << ", hardware threads: " << std::thread::hardware_concurrency() << "\n\n";
+    std::cout << std::left << std::setw(10) << "num-cpu"
+              << std::setw(16) << "instructions"
+              << std::setw(12) << "seconds"
+              << std::setw(16) << "instr/sec"
+              << "speedup\n";
+    std::cout << std::string(62, '-') << "\n";
+
+    startSnapshotWriter();
+    startLogFlusher();
+    startSleepTicker();
+    double baseline = 0;
+    for (int cores = 1; cores <= maxCores; ++cores)
+    {
+        BenchmarkResult result = runScalingPass(cores, programs);
+        double rate = result.seconds > 0 ? result.instructions / result.seconds : 0;
+        if (cores == 1)
+            baseline = rate;
+        std::cout << std::left << std::setw(10) << result.cores
+                  << std::setw(16) << result.instructions
+                  << std::setw(12) << std::fixed << std::setprecision(3) << result.seconds
+                  << std::setw(16) << std::setprecision(0) << rate
+                  << std::setprecision(2) << (baseline > 0 ? rate / baseline : 0) << "x\n";
+    }
+    stopSleepTicker();
+    stopSnapshotWriter();
+    stopLogFlusher();
+    return 0;
+}
@@ -5,6 +5,9 @@
 #include <iomanip>
 #include <sstream>
 #include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <charconv>
 #include <vector>
 #include <random>
 #include <sstream>
@@ -19,12 +22,32 @@
 #include <mutex>
 #include <deque>
 #include <unordered_map>
+#include <map>
+#include <set>
+#include <memory>
+#include <algorithm>
+#include <limits>
+#include <functional>
 
 std::atomic<bool> schedulerRunning(false);
 std::thread schedulerGeneratorThread;
+std::mutex generatorMutex;
+std::condition_variable generatorCv; // wakes the generator between spawns when the scheduler stops
+
+// Clears schedulerRunning and joins the wall-clock generator without waiting out its spawn interval
+void stopGenerator()
+{
+    {
+        std::lock_guard<std::mutex> lock(generatorMutex);
+        schedulerRunning = false;
+    }
+    generatorCv.notify_all();
+    if (schedulerGeneratorThread.joinable())
+        schedulerGeneratorThread.join();
+}
 std::mutex screensMutex;                                  // guards the `screens` vector during pushes
-std::unordered_map<std::string, uint16_t> physicalMemory; // key = "0x500"
-std::mutex physicalMemoryMutex;
+std::vector<uint16_t> physicalMemory; // one word per address, frame f starts at f * MEM_FRAME_SIZE
+std::mutex pagerMutex; // guards the frame table, free list and replacement policy; taken before any page table lock
 
 struct Config
 {
@@ -47,11 +70,27 @@ int maxInstructions = 10;
 int delayPerExec = 100;
 std::string schedulerAlgo = "rr";
 std::string output_dir = "./";
+std::string configFile = "config.txt"; // read by initialize; --batch takes its own
+bool logInstructions = true; // per-instruction lines in <output_dir>/<process>.txt
+int snapshotInterval = 0;            // instructions between memory snapshots, 0 = every quantum
+std::string snapshotFormat = "text"; // "text": memory_stamp_<n>.txt files, "binary": one memory_stamps.bin stream
+std::string clockMode = "wall";      // "virtual": ticks are loop iterations of one scheduler thread, nothing sleeps
+int maxTicks = 0;                    // virtual clock: ticks after scheduler-start until generation stops on its own, 0 = at scheduler-stop
+int programPoolSize = 32;            // generated programs kept per memory size and shared by new processes, 0 = fresh each time
+int consoleBufferLines = 50;         // PRINT lines kept per process, older ones are overwritten
+int retainFinished = 100;            // finished processes kept in full before being compacted into summaries
+int mlfqBoostTicks = 1000;           // instructions between MLFQ boosts back to level 0, 0 = never
+std::atomic<uint64_t> virtualTick{0};
 std::atomic<int> totalTicks{0};
 std::atomic<int> activeTicks{0};
 std::atomic<int> idleTicks{0};
 std::atomic<int> pagesPagedIn{0};
 std::atomic<int> pagesPagedOut{0};
+std::atomic<int> pagesWrittenBack{0};  // dirty evictions copied to the backing store
+std::atomic<int> pagesDroppedClean{0}; // clean evictions discarded without I/O
+std::atomic<long long> pageAccesses{0};
+std::string pageReplacementAlgo = "fifo";
+std::string pageTraceFile = ""; // recorded by fifo/clock/second-chance/lru, replayed by opt
 
 std::deque<std::thread> cpuThreads;
 int MEM_TOTAL = 16384;
@@ -66,144 +105,376 @@ struct MemoryBlock
     std::string owner;
 };
 
-std::vector<MemoryBlock> memoryBlocks = {{0, MEM_TOTAL, ""}}; // initially all free
-std::mutex memMutex;
-
-struct FrameTableEntry
+// Hands out contiguous ranges of the MEM_TOTAL address space to processes; callers hold memMutex
+struct MemoryAllocator
 {
-    bool occupied = false;
-    std::string ownerProcess;
-    int virtualPageNumber = -1; // which page of the process is stored here
+    int usedBytes = 0;
+    int requestedBytes = 0; // sum of the sizes processes asked for, to measure internal fragmentation
+    long long allocations = 0;
+    long long failedAllocations = 0;
+
+    virtual ~MemoryAllocator() = default;
+    virtual std::string name() const = 0;
+    virtual int allocate(const std::string &procName, int memSize) = 0; // start address or -1
+    virtual void release(const std::string &procName) = 0;
+    virtual std::vector<MemoryBlock> blocks() const = 0; // address-ordered, free blocks have no owner
 };
 
-std::vector<FrameTableEntry> frameTable;
-std::queue<int> fifoFrameQueue; // tracks frame usage order for FIFO replacement
+struct FirstFitAllocator : public MemoryAllocator
+{
+    std::vector<MemoryBlock> memoryBlocks;
+
+    explicit FirstFitAllocator(int totalSize) : memoryBlocks{{0, totalSize, ""}} {} // initially all free
+
+    std::string name() const override { return "first-fit"; }
+
+    int allocate(const std::string &procName, int memSize) override
+    {
+        for (size_t i = 0; i < memoryBlocks.size(); ++i)
+        {
+            auto &block = memoryBlocks[i];
+            if (block.owner.empty() && block.size >= memSize)
+            {
+                int allocStart = block.start;
+
+                usedBytes += memSize;
+                requestedBytes += memSize;
+
+                // Case 1: Exact fit
+                if (block.size == memSize)
+                {
+                    block.owner = procName;
+                    return allocStart;
+                }
+
+                // Case 2: Need to split
+                MemoryBlock allocated{block.start, memSize, procName};
+                MemoryBlock leftover{block.start + memSize, block.size - memSize, ""};
+
+                // Replace the original free block with two new blocks
+                memoryBlocks[i] = allocated;
+                memoryBlocks.insert(memoryBlocks.begin() + i + 1, leftover);
+
+                return allocStart;
+            }
+        }
+        return -1; // no fit found
+    }
+
+    void release(const std::string &procName) override
+    {
+        for (auto &block : memoryBlocks)
+        {
+            if (block.owner == procName)
+            {
+                usedBytes -= block.size;
+                requestedBytes -= block.size;
+                block.owner = "";
+            }
+        }
+
+        for (size_t i = 0; i + 1 < memoryBlocks.size();)
+        {
+            if (memoryBlocks[i].owner.empty() && memoryBlocks[i + 1].owner.empty())
+            {
+                memoryBlocks[i].size += memoryBlocks[i + 1].size;
+                memoryBlocks.erase(memoryBlocks.begin() + i + 1);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+
+    std::vector<MemoryBlock> blocks() const override { return memoryBlocks; }
+};
 
-bool isValidMemoryAccess(const std::string &procName, const std::string &hexAddress)
+// Binary buddy allocator: per-order free lists, blocks split on allocate and merged with their buddy on free
+struct BuddyAllocator : public MemoryAllocator
 {
-    // Convert hex string to int
-    int addr = 0;
-    try
+    struct Allocation
+    {
+        int start;
+        int order;
+        int requested;
+    };
+
+    int totalSize;
+    std::vector<std::set<int>> freeLists; // index = order, value = start addresses
+    std::unordered_map<std::string, std::vector<Allocation>> allocationsByOwner;
+
+    static int orderFor(int size)
     {
-        addr = std::stoi(hexAddress, nullptr, 16);
+        int order = 0;
+        while ((1 << order) < size)
+            order++;
+        return order;
     }
-    catch (...)
+
+    explicit BuddyAllocator(int size) : totalSize(size)
     {
-        return false; // Invalid hex format
+        freeLists.resize(orderFor(std::max(size, 1)) + 1);
+        // Cover a non power-of-two memory with the largest aligned blocks that fit
+        int addr = 0;
+        while (addr < totalSize)
+        {
+            int order = static_cast<int>(freeLists.size()) - 1;
+            while (order > 0 && ((addr & ((1 << order) - 1)) != 0 || addr + (1 << order) > totalSize))
+                order--;
+            freeLists[order].insert(addr);
+            addr += 1 << order;
+        }
     }
 
-    std::lock_guard<std::mutex> lock(memMutex);
-    for (const auto &block : memoryBlocks)
+    std::string name() const override { return "buddy"; }
+
+    int allocate(const std::string &procName, int memSize) override
     {
-        if (block.owner == procName)
+        int order = orderFor(std::max(memSize, 1));
+        int found = order;
+        while (found < (int)freeLists.size() && freeLists[found].empty())
+            found++;
+        if (found >= (int)freeLists.size())
+            return -1;
+
+        int start = *freeLists[found].begin();
+        freeLists[found].erase(freeLists[found].begin());
+        while (found > order)
+        {
+            found--;
+            freeLists[found].insert(start + (1 << found)); // upper half becomes a free buddy
+        }
+
+        allocationsByOwner[procName].push_back({start, order, memSize});
+        usedBytes += 1 << order;
+        requestedBytes += memSize;
+        return start;
+    }
+
+    void release(const std::string &procName) override
+    {
+        auto it = allocationsByOwner.find(procName);
+        if (it == allocationsByOwner.end())
+            return;
+
+        for (const Allocation &alloc : it->second)
         {
-            if (addr >= block.start && addr < block.start + block.size)
+            usedBytes -= 1 << alloc.order;
+            requestedBytes -= alloc.requested;
+
+            int start = alloc.start;
+            int order = alloc.order;
+            while (order + 1 < (int)freeLists.size())
             {
-                return true;
+                int buddy = start ^ (1 << order);
+                auto buddyIt = freeLists[order].find(buddy);
+                if (buddyIt == freeLists[order].end())
+                    break;
+                freeLists[order].erase(buddyIt);
+                start = std::min(start, buddy);
+                order++;
             }
+            freeLists[order].insert(start);
         }
+        allocationsByOwner.erase(it);
+    }
+
+    std::vector<MemoryBlock> blocks() const override
+    {
+        std::vector<MemoryBlock> result;
+        for (int order = 0; order < (int)freeLists.size(); ++order)
+            for (int start : freeLists[order])
+                result.push_back({start, 1 << order, ""});
+        for (const auto &kv : allocationsByOwner)
+            for (const Allocation &alloc : kv.second)
+                result.push_back({alloc.start, 1 << alloc.order, kv.first});
+        std::sort(result.begin(), result.end(), [](const MemoryBlock &a, const MemoryBlock &b)
+                  { return a.start < b.start; });
+        return result;
     }
-    return false;
+};
+
+std::string memAllocatorAlgo = "first-fit";
+std::unique_ptr<MemoryAllocator> memoryAllocator;
+std::mutex memMutex;
+
+std::unique_ptr<MemoryAllocator> makeMemoryAllocator(const std::string &algo, int totalSize)
+{
+    if (algo == "buddy")
+        return std::make_unique<BuddyAllocator>(totalSize);
+    if (algo != "first-fit")
+        std::cout << "Unknown mem-allocator " << algo << ", using first-fit.\n";
+    return std::make_unique<FirstFitAllocator>(totalSize);
+}
+
+std::vector<MemoryBlock> snapshotMemoryBlocks()
+{
+    std::lock_guard<std::mutex> lock(memMutex);
+    return memoryAllocator->blocks();
+}
+
+std::mt19937 randomEngine{std::random_device{}()};
+std::mutex randomMutex;
+
+// A fixed random-seed makes generated programs and priorities repeatable across runs
+void seedRandom(unsigned seed)
+{
+    std::lock_guard<std::mutex> lock(randomMutex);
+    randomEngine.seed(seed);
 }
 
 int getRand(int min, int max)
 {
-    std::random_device rd;
-    std::mt19937 gen(rd());
     std::uniform_int_distribution<> dist(min, max);
-    return dist(gen);
+    std::lock_guard<std::mutex> lock(randomMutex);
+    return dist(randomEngine);
 }
 
-std::string getCurrentDateTime()
+// "MM/DD/YYYY hh:mm:ss AM" for `t`; each thread formats a given second at most once
+const std::string &formatTimestamp(time_t t)
 {
-    time_t t = time(nullptr);
-    tm *tm_info = localtime(&t);
-    int hour = tm_info->tm_hour % 12;
+    thread_local time_t cachedSecond = -1;
+    thread_local std::string cachedText;
+    if (t == cachedSecond)
+        return cachedText;
+
+    tm tm_info; // cores call this concurrently, so avoid localtime's shared buffer
+#ifdef _WIN32
+    localtime_s(&tm_info, &t);
+#else
+    localtime_r(&t, &tm_info);
+#endif
+    int hour = tm_info.tm_hour % 12;
     if (hour == 0)
         hour = 12;
-    const char *ampm = (tm_info->tm_hour >= 12) ? "PM" : "AM";
-    char buf[30];
+    const char *ampm = (tm_info.tm_hour >= 12) ? "PM" : "AM";
+    char buf[80]; // room for every field at full int width, so the output can never be truncated
     snprintf(buf, sizeof(buf), "%02d/%02d/%04d %02d:%02d:%02d %s",
-             tm_info->tm_mon + 1, tm_info->tm_mday, tm_info->tm_year + 1900,
-             hour, tm_info->tm_min, tm_info->tm_sec, ampm);
-    return std::string(buf);
+             tm_info.tm_mon + 1, tm_info.tm_mday, tm_info.tm_year + 1900,
+             hour, tm_info.tm_min, tm_info.tm_sec, ampm);
+    cachedSecond = t;
+    cachedText = buf;
+    return cachedText;
 }
 
-int allocateMemory(const std::string &procName, int memSize)
+std::string getCurrentDateTime()
 {
-    std::lock_guard<std::mutex> lock(memMutex);
-    for (size_t i = 0; i < memoryBlocks.size(); ++i)
+    return formatTimestamp(time(nullptr));
+}
+
+// `text` as the body of a JSON string: quotes, backslashes and control characters escaped
+std::string jsonEscape(const std::string &text)
+{
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (char c : text)
     {
-        auto &block = memoryBlocks[i];
-        if (block.owner.empty() && block.size >= memSize)
+        switch (c)
         {
-            int allocStart = block.start;
-
-            // Case 1: Exact fit
-            if (block.size == memSize)
+        case '"':
+            escaped += "\\\"";
+            break;
+        case '\\':
+            escaped += "\\\\";
+            break;
+        case '\n':
+            escaped += "\\n";
+            break;
+        case '\r':
+            escaped += "\\r";
+            break;
+        case '\t':
+            escaped += "\\t";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
             {
-                block.owner = procName;
-                return allocStart;
+                char code[8];
+                snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned char>(c));
+                escaped += code;
+            }
+            else
+            {
+                escaped += c;
             }
-
-            // Case 2: Need to split
-            MemoryBlock allocated{block.start, memSize, procName};
-            MemoryBlock leftover{block.start + memSize, block.size - memSize, ""};
-
-            // Replace the original free block with two new blocks
-            memoryBlocks[i] = allocated;
-            memoryBlocks.insert(memoryBlocks.begin() + i + 1, leftover);
-
-            return allocStart;
         }
     }
-    return -1; // no fit found
+    return escaped;
 }
 
-void freeMemory(const std::string &procName)
+int allocateMemory(const std::string &procName, int memSize)
 {
     std::lock_guard<std::mutex> lock(memMutex);
-    for (auto &block : memoryBlocks)
-    {
-        if (block.owner == procName)
-        {
-            block.owner = "";
-        }
-    }
-
-    for (size_t i = 0; i + 1 < memoryBlocks.size();)
+    int start = memoryAllocator->allocate(procName, memSize);
+    if (start == -1)
     {
-        if (memoryBlocks[i].owner.empty() && memoryBlocks[i + 1].owner.empty())
-        {
-            memoryBlocks[i].size += memoryBlocks[i + 1].size;
-            memoryBlocks.erase(memoryBlocks.begin() + i + 1);
-        }
-        else
-        {
-            ++i;
-        }
+        memoryAllocator->failedAllocations++;
+        return -1;
     }
+    memoryAllocator->allocations++;
+    return start;
+}
 
-    int totalMem = 0;
-    for (const auto &b : memoryBlocks)
-        totalMem += b.size;
+void freeMemory(const std::string &procName)
+{
+    std::lock_guard<std::mutex> lock(memMutex);
+    memoryAllocator->release(procName);
 }
 
+// A mutex that can sit inside copyable structs: a copy gets its own, unlocked mutex
+struct CopyableMutex
+{
+    std::mutex m;
+
+    CopyableMutex() = default;
+    CopyableMutex(const CopyableMutex &) {}
+    CopyableMutex &operator=(const CopyableMutex &) { return *this; }
+
+    void lock() { m.lock(); }
+    void unlock() { m.unlock(); }
+    bool try_lock() { return m.try_lock(); }
+};
+
+// One executed instruction, formatted into a log line by the flusher
+struct LogRecord
+{
+    time_t stamp;
+    int coreId;
+    std::string text;
+};
+
+// Log lines of one process waiting for the log flusher thread
+struct ProcessLog
+{
+    std::mutex mutex;
+    std::string path;
+    std::vector<LogRecord> pending;
+    bool closed = false; // process exited; dropped once pending is written
+};
+
 struct Screen
 {
+    int pid = 0;
     int cpuId;
     int currentLine;
     int totalLines;
     std::string createdDate;
     std::string finishedDate;
     std::string name;
-    std::string lastLogTime;
+    time_t lastLogStamp = 0; // raw wall clock of the last instruction, formatted only for display
     std::string finishedTime;
 
     virtual ~Screen() = default;
 };
 
-enum class InstructionType
+// Last Log column: empty until the process has executed an instruction
+std::string formatLastLog(const Screen &screen)
+{
+    return screen.lastLogStamp == 0 ? std::string() : formatTimestamp(screen.lastLogStamp);
+}
+
+enum class InstructionType : uint8_t
 {
     DECLARE,
     PRINT,
@@ -211,9 +482,13 @@ enum class InstructionType
     SUBTRACT,
     SLEEP,
     READ,
-    WRITE
+    WRITE,
+    FOR,    // repeats subInstructions repeatCount times; compiles to a loop header
+    FOR_END // compiled loop footer, never parsed or generated
 };
 
+const int MAX_FOR_DEPTH = 3; // deepest FOR nesting the parser and generator accept
+
 struct Instruction
 {
     InstructionType type;
@@ -225,225 +500,1905 @@ struct Instruction
     int repeatCount = 1;
 };
 
-struct ProcessMemory
+const uint16_t NO_SLOT = 0xFFFF;
+
+// Compact POD form of an Instruction: variables are slot numbers, addresses and immediates are pre-parsed
+struct Bytecode
 {
-    std::unordered_map<std::string, uint16_t> vars;
+    InstructionType type;
+    uint16_t dst = NO_SLOT;  // DECLARE/ADD/SUBTRACT/READ target slot
+    uint16_t src1 = NO_SLOT; // operand slots, NO_SLOT means the matching immediate is used
+    uint16_t src2 = NO_SLOT;
+    uint16_t imm1 = 0; // DECLARE value, SLEEP ticks, or literal operands
+    uint16_t imm2 = 0;
+    int32_t address = -1; // READ/WRITE address (-1 if not valid hex), or FOR/FOR_END jump target
+    int32_t text = -1;    // index into Program::strings (PRINT message or READ/WRITE address operand)
 };
 
-struct ExecutableScreen : public Screen
+// Immutable once compiled and shared between processes, so nothing in it may name a process.
+// PROCESS_NAME_TOKEN in a PRINT message is replaced with the running process's name at print time.
+struct Program
 {
-    std::vector<Instruction> instructions;
-    ProcessMemory memory;
-    int instructionPointer = 0;
-    std::vector<std::pair<int, int>> forStack; // pair<index, remaining count>
-    bool isShutdown = false;
-    std::string shutdownMessage;
-    int memorySize = 0;
-    std::vector<std::string> consoleOutput;
-
-    struct PageTableEntry
-    {
-        bool present = false;
-        int frameNumber = -1;
-        bool dirty = false;
-    };
-
-    std::unordered_map<int, PageTableEntry> pageTable; // key = virtual page number
+    std::vector<Bytecode> code;
+    std::vector<std::string> slotNames; // slot -> variable name, for logs and printScreen
+    std::vector<std::string> strings;   // kept verbatim so log lines read as before
 };
 
-ExecutableScreen *activePerCore[128] = {nullptr}; // max 128 cores supported
-
-ExecutableScreen createScreen(std::string name)
-{
-    ExecutableScreen newScreen;
-    newScreen.cpuId = 0;
-    newScreen.currentLine = 0;
-    newScreen.totalLines = 100;
-    newScreen.createdDate = getCurrentDateTime();
-    newScreen.name = name;
-    return newScreen;
-}
+const std::string PROCESS_NAME_TOKEN = "{name}";
+const std::shared_ptr<const Program> EMPTY_PROGRAM = std::make_shared<const Program>();
 
-void shutdownProcess(ExecutableScreen &proc, const std::string &offendingAddr)
+// Appends `text` to `out` with every {name} replaced by the process name; reuses out's capacity
+void appendPrintText(std::string &out, const std::string &text, const std::string &procName)
 {
-    proc.isShutdown = true;
-    proc.finishedTime = getCurrentDateTime();
-
-    std::string formattedAddr = offendingAddr;
-    if (formattedAddr.find("0x") != 0)
+    size_t start = 0;
+    for (size_t pos = text.find(PROCESS_NAME_TOKEN); pos != std::string::npos; pos = text.find(PROCESS_NAME_TOKEN, start))
     {
-        try
-        {
-            int addrVal = std::stoi(offendingAddr);
-            std::stringstream ss;
-            ss << "0x" << std::uppercase << std::hex << addrVal;
-            formattedAddr = ss.str();
-        }
-        catch (...)
-        {
-        }
+        out.append(text, start, pos - start).append(procName);
+        start = pos + PROCESS_NAME_TOKEN.size();
     }
-
-    proc.shutdownMessage = "Process " + proc.name +
-                           " shut down due to memory access violation error that occurred at " +
-                           proc.finishedTime + ". " + formattedAddr + " invalid.";
-    freeMemory(proc.name);
+    out.append(text, start, std::string::npos);
 }
 
-void printScreen(const ExecutableScreen &screen)
+void appendNumber(std::string &out, int value)
 {
-    std::cout << "Screen Title: " << screen.name << "\n";
-    std::cout << "Current Line: " << screen.currentLine << "/" << screen.totalLines << "\n";
-    std::cout << "Created Date: " << screen.createdDate << "\n";
-    std::cout << "Variables:\n";
-    for (const auto &kv : screen.memory.vars)
-    {
-        std::cout << "  " << kv.first << " = " << kv.second << "\n";
-    }
-    if (!screen.consoleOutput.empty())
-    {
-        std::cout << "Console Output:\n";
-        for (const auto &line : screen.consoleOutput)
-        {
-            std::cout << "  " << line << "\n";
-        }
-    }
+    char digits[12];
+    char *end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+    out.append(digits, end);
 }
 
-void printHeader()
+bool isNumericOperand(const std::string &token)
 {
-    std::cout << "   ___________ ____  ____  _____________  __ \n"
-              << "  / ____/ ___// __ \\/ __ \\/ ____/ ___/\\ \\/ / \n"
-              << " / /    \\__ \\/ / / / /_/ / __/  \\__ \\  \\  /  \n"
-              << "/ /___ ___/ / /_/ / ____/ /___ ___/ /  / /   \n"
-              << "\\____//____/\\____/_/   /_____//____/  /_/    \n"
-              << "                                             \n"
-              << "Type 'exit' to quit, 'clear' to clear the screen\n\n";
+    if (token.empty())
+        return false;
+    size_t digit = (token[0] == '-' || token[0] == '+') ? 1 : 0;
+    return digit < token.size() && std::isdigit(static_cast<unsigned char>(token[digit]));
 }
 
-void clearScreen()
+// Leading decimal literal of `token` if it fits an int, like std::stoi but without throwing
+bool parseLiteralOperand(const std::string &token, int &value)
 {
-#ifdef _WIN32
-    std::system("cls");
-#else
-    std::system("clear");
-#endif
+    errno = 0;
+    char *end = nullptr;
+    long long parsed = std::strtoll(token.c_str(), &end, 10);
+    if (errno == ERANGE || end == token.c_str() ||
+        parsed < std::numeric_limits<int>::min() || parsed > std::numeric_limits<int>::max())
+        return false;
+    value = static_cast<int>(parsed);
+    return true;
 }
 
-std::queue<ExecutableScreen *> readyQueue;
-std::mutex queueMutex;
-std::condition_variable cv;
-bool stopScheduler = false;
-
-int findFreeFrame()
+int parseAddressOperand(const std::string &token)
 {
-    for (int i = 0; i < (int)frameTable.size(); ++i)
+    try
     {
-        if (!frameTable[i].occupied)
-            return i;
+        return std::stoi(token, nullptr, 16);
+    }
+    catch (...)
+    {
+        return -1;
     }
-    return -1;
 }
 
-bool restorePageFromBackingStore(const std::string &procName, int virtualPage, int frameNum)
+// Resolves variable names to slots and parses operands once, so the interpreter never hashes or allocates
+Program compileProgram(const std::vector<Instruction> &instructions)
 {
-    std::ifstream in("csopesy-backing-store.txt");
-    if (!in.is_open())
-        return false;
+    Program program;
+    std::unordered_map<std::string, uint16_t> slots;
 
-    std::string line;
-    while (std::getline(in, line))
+    auto slotFor = [&](const std::string &name)
+    {
+        auto it = slots.find(name);
+        if (it != slots.end())
+            return it->second;
+        uint16_t slot = static_cast<uint16_t>(program.slotNames.size());
+        program.slotNames.push_back(name);
+        slots[name] = slot;
+        return slot;
+    };
+    // A literal that does not parse stays a name that is never declared, so it reads as 0
+    // and WRITE reports "value not found", as before compilation
+    auto operand = [&](const std::string &token, uint16_t &slot, uint16_t &imm)
+    {
+        int literal = 0;
+        if (isNumericOperand(token) && parseLiteralOperand(token, literal))
+            imm = static_cast<uint16_t>(literal);
+        else
+            slot = slotFor(token);
+    };
+    auto addString = [&](const std::string &text)
     {
-        std::istringstream iss(line);
-        std::string name;
-        int page;
-        iss >> name >> page;
+        program.strings.push_back(text);
+        return static_cast<int32_t>(program.strings.size() - 1);
+    };
 
-        if (name == procName && page == virtualPage)
+    // FOR bodies are emitted once between a FOR header and a FOR_END footer; the loop
+    // runs through forStack at execution time instead of copying the body per iteration
+    std::function<void(const std::vector<Instruction> &)> emit = [&](const std::vector<Instruction> &block)
+    {
+        for (const auto &inst : block)
         {
-            int baseAddr = frameNum * MEM_FRAME_SIZE;
-            for (int i = 0; i < MEM_FRAME_SIZE; ++i)
+            Bytecode code;
+            code.type = inst.type;
+            switch (inst.type)
             {
-                uint16_t val;
-                if (!(iss >> val))
-                    break;
-                std::string addr = "0x" + std::to_string(baseAddr + i);
-                std::lock_guard<std::mutex> lock(physicalMemoryMutex);
-                physicalMemory[addr] = val;
+            case InstructionType::DECLARE:
+                code.dst = slotFor(inst.var1);
+                code.imm1 = inst.value;
+                break;
+            case InstructionType::PRINT:
+                code.text = addString(inst.message);
+                if (!inst.var1.empty())
+                    code.src1 = slotFor(inst.var1);
+                break;
+            case InstructionType::ADD:
+            case InstructionType::SUBTRACT:
+                code.dst = slotFor(inst.var1);
+                operand(inst.var2, code.src1, code.imm1);
+                operand(inst.var3, code.src2, code.imm2);
+                break;
+            case InstructionType::SLEEP:
+                code.imm1 = inst.sleepTicks;
+                break;
+            case InstructionType::WRITE:
+                code.address = parseAddressOperand(inst.var1);
+                code.text = addString(inst.var1);
+                operand(inst.var2, code.src1, code.imm1);
+                break;
+            case InstructionType::READ:
+                code.dst = slotFor(inst.var1);
+                code.address = parseAddressOperand(inst.var2);
+                code.text = addString(inst.var2);
+                break;
+            case InstructionType::FOR:
+            {
+                int header = static_cast<int>(program.code.size());
+                code.imm1 = static_cast<uint16_t>(std::max(0, std::min(inst.repeatCount, 0xFFFF)));
+                program.code.push_back(code);
+                emit(inst.subInstructions);
+                Bytecode footer;
+                footer.type = InstructionType::FOR_END;
+                footer.address = header + 1; // first body instruction
+                program.code.push_back(footer);
+                program.code[header].address = static_cast<int32_t>(program.code.size()); // past the footer
+                continue;
             }
-            return true;
+            default:
+                break;
+            }
+            program.code.push_back(code);
         }
-    }
-    return false;
+    };
+
+    program.code.reserve(instructions.size());
+    emit(instructions);
+    return program;
 }
 
-int evictPageAndReturnFrame()
+// Instructions a program executes once every loop is unrolled; FOR headers and footers do not count
+int countExecutedLines(const Program &program)
 {
-    if (fifoFrameQueue.empty())
-        return -1; // no pages to evict
+    long long total = 0;
+    std::vector<long long> repeats = {1};
+    for (const Bytecode &code : program.code)
+    {
+        if (code.type == InstructionType::FOR)
+            repeats.push_back(std::min<long long>(repeats.back() * code.imm1, std::numeric_limits<int>::max()));
+        else if (code.type == InstructionType::FOR_END)
+            repeats.pop_back();
+        else
+            total += repeats.back();
+    }
+    return static_cast<int>(std::min<long long>(total, std::numeric_limits<int>::max()));
+}
 
-    int victimFrame = fifoFrameQueue.front();
-    fifoFrameQueue.pop();
+const int SYMBOL_TABLE_BYTES = 64; // up to 32 two-byte variables at the start of every process
 
-    FrameTableEntry &victim = frameTable[victimFrame];
-    std::string procName = victim.ownerProcess;
-    int virtualPage = victim.virtualPageNumber;
+struct ProcessMemory
+{
+    uint32_t declared = 0;             // bit per slot; the values themselves live in the symbol table page
+    std::vector<uint16_t> finalValues; // symbol table copied out when the process releases its pages, or into a snapshot
+
+    bool isDeclared(uint16_t slot) const
+    {
+        return slot < 32 && ((declared >> slot) & 1u);
+    }
+};
+
+// Fixed-capacity console output: once full, every PRINT overwrites the oldest line
+struct ConsoleRing
+{
+    std::vector<std::string> lines;
+    size_t head = 0;       // oldest line once the ring is full
+    long long dropped = 0; // lines overwritten so far
+
+    std::string spare; // stands in for a slot when console-buffer-lines is 0
+
+    // Empty string for the next line, to be filled in place. Once the ring is full this is the
+    // oldest slot, so a steady stream of PRINTs reuses its capacity instead of allocating.
+    std::string &nextLine()
+    {
+        if (consoleBufferLines <= 0)
+        {
+            dropped++;
+            spare.clear();
+            return spare;
+        }
+        if (lines.size() < static_cast<size_t>(consoleBufferLines))
+            return lines.emplace_back();
+        std::string &line = lines[head];
+        head = (head + 1) % lines.size();
+        dropped++;
+        line.clear();
+        return line;
+    }
+
+    bool empty() const { return lines.empty(); }
+
+    template <typename Fn>
+    void forEach(Fn fn) const
+    {
+        for (size_t i = 0; i < lines.size(); ++i)
+            fn(lines[(head + i) % lines.size()]);
+    }
+};
+
+// What is left of a finished process once the retention policy has freed its program and page table
+struct ProcessSummary : public Screen
+{
+    int memorySize = 0;
+    bool isShutdown = false;
+    std::string shutdownMessage;
+};
+
+// Status-table entry of one process. The owning core publishes after every instruction under a
+// seqlock, so process-smi and screen -ls read consistent rows without ever taking stateMutex.
+struct ProcessStatusSlot
+{
+    // Written at registration under statusTableMutex, before any core can run the process
+    int pid = 0;
+    std::string name;
+    int memorySize = 0;
+    bool inUse = false; // false once the process is compacted and the slot waits for reuse
+
+    std::atomic<uint32_t> sequence{0}; // odd while the owning core is writing
+    std::atomic<int> cpuId{0};
+    std::atomic<int> currentLine{0};
+    std::atomic<int> totalLines{0};
+    std::atomic<time_t> lastLogStamp{0};
+    std::atomic<time_t> finishedStamp{0};
+    std::atomic<bool> isShutdown{false};
+};
+
+// One row of the status table as a reader saw it
+struct ProcessStatusView : public Screen
+{
+    int memorySize = 0;
+    bool isShutdown = false;
+};
+
+struct ExecutableScreen : public Screen
+{
+    std::shared_ptr<const Program> program = EMPTY_PROGRAM;
+    ProcessMemory memory;
+    int instructionPointer = 0;
+    std::vector<std::pair<int, int>> forStack; // pair<index, remaining count>
+    bool isShutdown = false;
+    std::string shutdownMessage;
+    int memorySize = 0;
+    int memoryBase = -1; // base register: start of the allocation in the MEM_TOTAL space
+    int memoryLimit = 0; // limit register: valid virtual addresses are [0, memoryLimit)
+    ConsoleRing consoleOutput;
+    std::shared_ptr<ProcessLog> log; // created by the first logged instruction
+    bool exited = false;             // set by finishProcess under stateMutex once no core touches the process again
+    bool compacted = false;          // retired into finishedSummaries; only the shell is left until popped from `screens`
+    ProcessStatusSlot *status = nullptr; // row in statusTable, null for processes outside `screens`
+
+    // Scheduling state, written by whichever core holds the process
+    int priority = 0;   // lower runs first under the priority scheduler, drawn at admission
+    int queueLevel = 0; // MLFQ level, demoted after using a full slice
+    int boostEpoch = 0; // last MLFQ boost applied to this process
+    bool admitted = false;
+    bool hasRun = false;
+    double arrivalMs = 0;  // simulation clock at first enqueue
+    double firstRunMs = 0; // simulation clock at first dispatch
+    double cpuMs = 0;      // time spent on a core
+
+    struct PageTableEntry
+    {
+        bool present = false;
+        int frameNumber = -1;
+        std::atomic<bool> dirty{false}; // set by cores under pageTableMutex, read by victim scans under pagerMutex only
+
+        PageTableEntry() = default;
+        PageTableEntry(const PageTableEntry &other)
+            : present(other.present), frameNumber(other.frameNumber), dirty(other.dirty.load()) {}
+        PageTableEntry &operator=(const PageTableEntry &other)
+        {
+            present = other.present;
+            frameNumber = other.frameNumber;
+            dirty = other.dirty.load();
+            return *this;
+        }
+    };
+
+    std::vector<PageTableEntry> pageTable; // index = virtual page number, sized once at allocation
+
+    mutable CopyableMutex stateMutex;     // held by the owning core per instruction and by observers reading state
+    mutable CopyableMutex pageTableMutex; // pins resident pages; taken after pagerMutex, never before it
+};
+
+std::deque<ProcessStatusSlot> statusTable;       // slots never move; compacted processes hand theirs back
+std::vector<ProcessStatusSlot *> freeStatusSlots; // slots of compacted processes, reused before the table grows
+std::mutex statusTableMutex;                      // guards registration, recycling and every reader; cores never take it
+std::atomic<ProcessStatusSlot *> activePerCore[128] = {}; // status of the process each core is running, max 128 cores
+
+// Adds the process's status row; called once it is in `screens`, before any core can run it
+void registerProcessStatus(ExecutableScreen &proc)
+{
+    std::lock_guard<std::mutex> lock(statusTableMutex);
+    ProcessStatusSlot *slot;
+    if (freeStatusSlots.empty())
+    {
+        slot = &statusTable.emplace_back();
+    }
+    else
+    {
+        slot = freeStatusSlots.back();
+        freeStatusSlots.pop_back();
+    }
+    slot->pid = proc.pid;
+    slot->name = proc.name;
+    slot->memorySize = proc.memorySize;
+    slot->inUse = true;
+    slot->cpuId.store(proc.cpuId, std::memory_order_relaxed);
+    slot->currentLine.store(proc.currentLine, std::memory_order_relaxed);
+    slot->totalLines.store(proc.totalLines, std::memory_order_relaxed);
+    slot->lastLogStamp.store(proc.lastLogStamp, std::memory_order_relaxed);
+    slot->finishedStamp.store(0, std::memory_order_relaxed);
+    slot->isShutdown.store(proc.isShutdown, std::memory_order_relaxed);
+    proc.status = slot;
+}
+
+// Hands the slot of a compacted process back for reuse. Its core cleared activePerCore and made its
+// last publish before finishedInFull counted it, so only a reader holding statusTableMutex can still see it.
+void releaseProcessStatus(ExecutableScreen &proc)
+{
+    if (!proc.status)
+        return;
+    std::lock_guard<std::mutex> lock(statusTableMutex);
+    proc.status->inUse = false;
+    freeStatusSlots.push_back(proc.status);
+    proc.status = nullptr;
+}
+
+// Seqlock write side; only the core that owns `proc` calls it
+void publishProcessStatus(const ExecutableScreen &proc, time_t finishedStamp = 0)
+{
+    ProcessStatusSlot *slot = proc.status;
+    if (!slot)
+        return;
+    uint32_t seq = slot->sequence.load(std::memory_order_relaxed);
+    slot->sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot->cpuId.store(proc.cpuId, std::memory_order_relaxed);
+    slot->currentLine.store(proc.currentLine, std::memory_order_relaxed);
+    slot->totalLines.store(proc.totalLines, std::memory_order_relaxed);
+    slot->lastLogStamp.store(proc.lastLogStamp, std::memory_order_relaxed);
+    slot->finishedStamp.store(finishedStamp, std::memory_order_relaxed);
+    slot->isShutdown.store(proc.isShutdown, std::memory_order_relaxed);
+    slot->sequence.store(seq + 2, std::memory_order_release);
+}
+
+// Seqlock read side: retries until it copies the row between two publishes
+ProcessStatusView readProcessStatus(const ProcessStatusSlot &slot)
+{
+    ProcessStatusView view;
+    view.pid = slot.pid;
+    view.name = slot.name;
+    view.memorySize = slot.memorySize;
+    while (true)
+    {
+        uint32_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before & 1u)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        view.cpuId = slot.cpuId.load(std::memory_order_relaxed);
+        view.currentLine = slot.currentLine.load(std::memory_order_relaxed);
+        view.totalLines = slot.totalLines.load(std::memory_order_relaxed);
+        view.lastLogStamp = slot.lastLogStamp.load(std::memory_order_relaxed);
+        time_t finished = slot.finishedStamp.load(std::memory_order_relaxed);
+        view.isShutdown = slot.isShutdown.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == before)
+        {
+            view.finishedTime = finished == 0 ? std::string() : formatTimestamp(finished);
+            return view;
+        }
+    }
+}
+
+std::deque<ProcessSummary> finishedSummaries; // compacted finished processes, oldest first; guarded by screensMutex
+std::atomic<int> finishedInFull{0};            // finished processes still holding their program and page table
+
+// Every process in creation order: compacted ones from their summaries, the rest from their slots.
+// Takes screensMutex so no process is compacted between the two reads; cores take neither lock.
+std::vector<ProcessStatusView> snapshotProcessStatus()
+{
+    std::lock_guard<std::mutex> screensLock(screensMutex);
+    std::lock_guard<std::mutex> lock(statusTableMutex);
+    std::vector<ProcessStatusView> rows;
+    rows.reserve(finishedSummaries.size() + statusTable.size() - freeStatusSlots.size());
+    for (const ProcessSummary &summary : finishedSummaries)
+    {
+        ProcessStatusView &row = rows.emplace_back();
+        static_cast<Screen &>(row) = static_cast<const Screen &>(summary);
+        row.memorySize = summary.memorySize;
+        row.isShutdown = summary.isShutdown;
+    }
+    for (const ProcessStatusSlot &slot : statusTable)
+    {
+        if (slot.inUse)
+            rows.push_back(readProcessStatus(slot));
+    }
+    std::sort(rows.begin(), rows.end(), [](const ProcessStatusView &a, const ProcessStatusView &b)
+              { return a.pid < b.pid; });
+    return rows;
+}
+
+// The process on each busy core as (core, row); under statusTableMutex so no slot is reused mid-read
+std::vector<std::pair<int, ProcessStatusView>> snapshotRunningStatus()
+{
+    std::lock_guard<std::mutex> lock(statusTableMutex);
+    std::vector<std::pair<int, ProcessStatusView>> running;
+    for (int i = 0; i < CPU_CORES; ++i)
+    {
+        ProcessStatusSlot *slot = activePerCore[i];
+        if (slot != nullptr)
+            running.emplace_back(i, readProcessStatus(*slot));
+    }
+    return running;
+}
+
+std::string processStatusLabel(const ProcessStatusView &row)
+{
+    if (row.isShutdown)
+        return "Shutdown";
+    return row.currentLine >= row.totalLines ? "Finished" : "Running";
+}
+std::atomic<int> processesFinished{0};         // every exit since startup, for --batch wait-finished
+
+// Runs FOR headers and footers until instructionPointer is on a real instruction or past the end,
+// so every step executes exactly one counted line and a finished loop never costs a tick
+void advancePastLoopControl(ExecutableScreen &proc)
+{
+    const std::vector<Bytecode> &code = proc.program->code;
+    while (proc.instructionPointer < static_cast<int>(code.size()))
+    {
+        const Bytecode &inst = code[proc.instructionPointer];
+        if (inst.type == InstructionType::FOR)
+        {
+            if (inst.imm1 == 0)
+            {
+                proc.instructionPointer = inst.address;
+                continue;
+            }
+            proc.forStack.emplace_back(proc.instructionPointer + 1, inst.imm1);
+            proc.instructionPointer++;
+        }
+        else if (inst.type == InstructionType::FOR_END)
+        {
+            auto &loop = proc.forStack.back();
+            if (--loop.second > 0)
+            {
+                proc.instructionPointer = loop.first;
+                continue;
+            }
+            proc.forStack.pop_back();
+            proc.instructionPointer++;
+        }
+        else
+            return;
+    }
+}
+
+void loadProgram(ExecutableScreen &proc, std::shared_ptr<const Program> program)
+{
+    proc.program = std::move(program);
+    proc.totalLines = countExecutedLines(*proc.program);
+    proc.memory = ProcessMemory{};
+    proc.instructionPointer = 0;
+    proc.forStack.clear();
+    advancePastLoopControl(proc);
+}
+
+struct FrameTableEntry
+{
+    bool occupied = false;
+    ExecutableScreen *owner = nullptr;                    // process whose page lives here
+    ExecutableScreen::PageTableEntry *pageEntry = nullptr; // owner's entry for that page, invalidated on eviction
+    int virtualPageNumber = -1;                            // which page of the process is stored here
+    std::atomic<bool> referenced{false};                   // set on READ/WRITE/DECLARE without the pager lock, cleared by the policy
+    uint8_t age = 0;                                       // aging counter for the LRU approximation
+    uint32_t loadStamp = 0;                                // bumped on every load so stale queue entries can be skipped
+    int nextFree = -1;                                     // intrusive free list link while unoccupied
+};
+
+std::vector<FrameTableEntry> frameTable;
+int freeFrameHead = -1; // first unoccupied frame, -1 when memory is full
+int freeFrameCount = 0;
+
+// Identifies a process's virtual page in the page trace and the backing store index
+uint64_t pageKey(int pid, int virtualPage)
+{
+    return (static_cast<uint64_t>(pid) << 32) | static_cast<uint32_t>(virtualPage);
+}
+
+// Chooses which resident page to evict once every frame is occupied
+struct ReplacementPolicy
+{
+    virtual ~ReplacementPolicy() = default;
+    virtual std::string name() const = 0;
+    virtual void onLoad(int) {}
+    virtual void onAccess(int) {}
+    virtual int selectVictim() = 0; // -1 if nothing can be evicted
+};
+
+struct FifoPolicy : public ReplacementPolicy
+{
+    std::queue<std::pair<int, uint32_t>> frameQueue; // pair<frame, load stamp> in load order
+
+    std::string name() const override { return "fifo"; }
+    void onLoad(int frame) override { frameQueue.push({frame, frameTable[frame].loadStamp}); }
+    int selectVictim() override
+    {
+        while (!frameQueue.empty())
+        {
+            auto [frame, stamp] = frameQueue.front();
+            frameQueue.pop();
+            // Frames released by an exiting process may have been reloaded since
+            if (frameTable[frame].occupied && frameTable[frame].loadStamp == stamp)
+                return frame;
+        }
+        return -1;
+    }
+};
+
+struct ClockPolicy : public ReplacementPolicy
+{
+    int hand = 0;
+
+    std::string name() const override { return "clock"; }
+    int selectVictim() override
+    {
+        int frames = static_cast<int>(frameTable.size());
+        // Two sweeps are enough: the first clears every reference bit
+        for (int step = 0; step < 2 * frames; ++step)
+        {
+            int frame = hand;
+            hand = (hand + 1) % frames;
+            FrameTableEntry &entry = frameTable[frame];
+            if (!entry.occupied)
+                continue;
+            if (!entry.referenced)
+                return frame;
+            entry.referenced = false;
+        }
+        return -1;
+    }
+};
+
+// Enhanced second chance: prefer (unreferenced, clean), then (unreferenced, dirty)
+struct SecondChancePolicy : public ReplacementPolicy
+{
+    int hand = 0;
+
+    std::string name() const override { return "second-chance"; }
+    int selectVictim() override
+    {
+        int frames = static_cast<int>(frameTable.size());
+        for (int round = 0; round < 2; ++round)
+        {
+            // Pass 1 looks for (0,0) without touching bits
+            for (int step = 0; step < frames; ++step)
+            {
+                int frame = (hand + step) % frames;
+                const FrameTableEntry &entry = frameTable[frame];
+                if (entry.occupied && !entry.referenced && !entry.pageEntry->dirty)
+                {
+                    hand = (frame + 1) % frames;
+                    return frame;
+                }
+            }
+            // Pass 2 looks for (0,1) and clears reference bits on the way
+            for (int step = 0; step < frames; ++step)
+            {
+                int frame = (hand + step) % frames;
+                FrameTableEntry &entry = frameTable[frame];
+                if (!entry.occupied)
+                    continue;
+                if (!entry.referenced)
+                {
+                    hand = (frame + 1) % frames;
+                    return frame;
+                }
+                entry.referenced = false;
+            }
+        }
+        return -1;
+    }
+};
+
+// LRU approximation: each fault ages every frame and evicts the smallest counter
+struct AgingPolicy : public ReplacementPolicy
+{
+    std::string name() const override { return "lru"; }
+    void onLoad(int frame) override { frameTable[frame].age = 0x80; }
+    int selectVictim() override
+    {
+        int victim = -1;
+        for (int frame = 0; frame < (int)frameTable.size(); ++frame)
+        {
+            FrameTableEntry &entry = frameTable[frame];
+            if (!entry.occupied)
+                continue;
+            entry.age = static_cast<uint8_t>((entry.age >> 1) | (entry.referenced ? 0x80 : 0));
+            entry.referenced = false;
+            if (victim == -1 || entry.age < frameTable[victim].age)
+                victim = frame;
+        }
+        return victim;
+    }
+};
+
+// Belady's OPT: replays a recorded access trace and evicts the page used furthest in the future
+struct OptPolicy : public ReplacementPolicy
+{
+    std::unordered_map<uint64_t, std::vector<uint32_t>> futureUses; // key -> trace positions
+    std::atomic<uint32_t> cursor{0}; // advanced from the hit path, which does not hold pagerMutex
+
+    explicit OptPolicy(const std::string &traceFile)
+    {
+        std::ifstream in(traceFile, std::ios::binary);
+        if (!in.is_open())
+        {
+            std::cerr << "OPT: cannot read page trace " << traceFile << ", every page is treated as unused.\n";
+            return;
+        }
+        uint64_t key;
+        uint32_t position = 0;
+        while (in.read(reinterpret_cast<char *>(&key), sizeof(key)))
+            futureUses[key].push_back(position++);
+    }
+
+    std::string name() const override { return "opt"; }
+    void onAccess(int) override { cursor++; }
+    int selectVictim() override
+    {
+        int victim = -1;
+        uint32_t farthest = 0;
+        for (int frame = 0; frame < (int)frameTable.size(); ++frame)
+        {
+            const FrameTableEntry &entry = frameTable[frame];
+            if (!entry.occupied)
+                continue;
+            uint32_t nextUse = UINT32_MAX;
+            auto it = futureUses.find(pageKey(entry.owner->pid, entry.virtualPageNumber));
+            if (it != futureUses.end())
+            {
+                auto pos = std::upper_bound(it->second.begin(), it->second.end(), cursor.load());
+                if (pos != it->second.end())
+                    nextUse = *pos;
+            }
+            if (nextUse == UINT32_MAX)
+                return frame; // never referenced again
+            if (victim == -1 || nextUse > farthest)
+            {
+                victim = frame;
+                farthest = nextUse;
+            }
+        }
+        return victim;
+    }
+};
+
+std::unique_ptr<ReplacementPolicy> replacementPolicy;
+std::ofstream pageTraceOut;
+
+struct PagingStats
+{
+    long long accesses = 0;
+    long long faults = 0;
+};
+std::map<std::string, PagingStats> pagingStatsByPolicy; // runs folded in on every initialize
+
+std::unique_ptr<ReplacementPolicy> makeReplacementPolicy(const std::string &algo)
+{
+    if (algo == "clock")
+        return std::make_unique<ClockPolicy>();
+    if (algo == "second-chance")
+        return std::make_unique<SecondChancePolicy>();
+    if (algo == "lru")
+        return std::make_unique<AgingPolicy>();
+    if (algo == "opt")
+        return std::make_unique<OptPolicy>(pageTraceFile);
+    if (algo != "fifo")
+        std::cout << "Unknown page-replacement " << algo << ", using fifo.\n";
+    return std::make_unique<FifoPolicy>();
+}
+std::atomic<int> nextProcessId{1};
+
+// Base/limit check against the registers cached at allocation time; no lock needed
+bool isValidMemoryAccess(const ExecutableScreen &proc, int addr)
+{
+    return addr >= 0 && addr < proc.memoryLimit;
+}
+
+// Allocates the process's memory and loads its base/limit registers
+bool allocateProcessMemory(ExecutableScreen &proc, int memSize)
+{
+    proc.memorySize = memSize;
+    int allocStart = allocateMemory(proc.name, memSize);
+    if (allocStart == -1)
+        return false;
+    proc.memoryBase = allocStart;
+    proc.memoryLimit = memSize;
+    proc.pageTable.assign((memSize + MEM_FRAME_SIZE - 1) / MEM_FRAME_SIZE, {});
+    return true;
+}
+
+std::string toHexAddress(int addr)
+{
+    std::stringstream ss;
+    ss << "0x" << std::uppercase << std::hex << addr;
+    return ss.str();
+}
+
+ExecutableScreen createScreen(std::string name)
+{
+    ExecutableScreen newScreen;
+    newScreen.pid = nextProcessId++;
+    newScreen.cpuId = 0;
+    newScreen.currentLine = 0;
+    newScreen.totalLines = 100;
+    newScreen.createdDate = getCurrentDateTime();
+    newScreen.name = name;
+    return newScreen;
+}
+
+void shutdownProcess(ExecutableScreen &proc, const std::string &offendingAddr)
+{
+    proc.isShutdown = true;
+    proc.finishedTime = getCurrentDateTime();
+
+    std::string formattedAddr = offendingAddr;
+    if (formattedAddr.find("0x") != 0)
+    {
+        try
+        {
+            int addrVal = std::stoi(offendingAddr);
+            std::stringstream ss;
+            ss << "0x" << std::uppercase << std::hex << addrVal;
+            formattedAddr = ss.str();
+        }
+        catch (...)
+        {
+        }
+    }
+
+    proc.shutdownMessage = "Process " + proc.name +
+                           " shut down due to memory access violation error that occurred at " +
+                           proc.finishedTime + ". " + formattedAddr + " invalid.";
+    freeMemory(proc.name);
+    proc.memoryLimit = 0;
+}
+
+void printHeader()
+{
+    std::cout << "   ___________ ____  ____  _____________  __ \n"
+              << "  / ____/ ___// __ \\/ __ \\/ ____/ ___/\\ \\/ / \n"
+              << " / /    \\__ \\/ / / / /_/ / __/  \\__ \\  \\  /  \n"
+              << "/ /___ ___/ / /_/ / ____/ /___ ___/ /  / /   \n"
+              << "\\____//____/\\____/_/   /_____//____/  /_/    \n"
+              << "                                             \n"
+              << "Type 'exit' to quit, 'clear' to clear the screen\n\n";
+}
+
+void clearScreen()
+{
+#ifdef _WIN32
+    std::system("cls");
+#else
+    std::system("clear");
+#endif
+}
+
+// Milliseconds on the simulation clock: wall time, or ticks * delay-per-exec in virtual mode
+double simulationNowMs()
+{
+    if (clockMode == "virtual")
+        return static_cast<double>(virtualTick.load()) * std::max(1, delayPerExec);
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Chrome trace (chrome://tracing, ui.perfetto.dev) of scheduling and paging events, enabled by
+// trace-file in config.txt. Every thread appends to its own fixed-size buffer without locking;
+// the buffers are written out at scheduler-stop, once the cores that fill them have been joined.
+std::string traceFile = "";        // empty disables tracing
+int traceBufferEvents = 65536;     // events kept per thread, later ones are dropped
+bool traceEnabled = false;         // set by initialize; every recording site checks only this
+double traceEpochUs = 0;           // simulation clock at initialize, trace timestamps start here
+thread_local int traceTid = -1;    // core id on cpu workers, set per core by the virtual scheduler
+
+const int TRACE_TID_GENERATOR = 1000;
+const int TRACE_TID_SLEEP_TICKER = 1001;
+
+struct TraceEvent
+{
+    const char *name;    // static event name, or null for a slice named by `label`
+    char phase;          // 'X' complete, 'i' instant, 'b'/'e' async begin/end
+    int tid;
+    double tsUs;
+    double durUs;
+    int pid;             // simulated process
+    const char *argName; // what `arg` holds: page, ticks, instructions or mem_size
+    int arg;
+    const char *end;     // why a slice left its core, null for other events
+    char label[16];      // process name for slices, truncated
+};
+
+struct TraceBuffer
+{
+    std::unique_ptr<TraceEvent[]> events;
+    int capacity = 0;
+    std::atomic<int> count{0}; // published after the event is written
+    long long dropped = 0;
+};
+
+// Buffers are never freed, so a thread can keep its pointer across writes. An exiting thread
+// returns its buffer to the free list and the next new thread reuses it, unwritten events and all.
+std::deque<TraceBuffer> traceBuffers;
+std::vector<TraceBuffer *> freeTraceBuffers;
+std::mutex traceBuffersMutex; // guards registration and the free list, never taken per event
+
+struct TraceBufferLease
+{
+    TraceBuffer *buffer = nullptr;
+
+    ~TraceBufferLease()
+    {
+        if (!buffer)
+            return;
+        std::lock_guard<std::mutex> lock(traceBuffersMutex);
+        freeTraceBuffers.push_back(buffer);
+    }
+};
+
+// The calling thread's buffer, taken on its first event; trace-buffer-events applies to new buffers
+TraceBuffer &localTraceBuffer()
+{
+    thread_local TraceBufferLease lease;
+    if (!lease.buffer)
+    {
+        std::lock_guard<std::mutex> lock(traceBuffersMutex);
+        if (!freeTraceBuffers.empty())
+        {
+            lease.buffer = freeTraceBuffers.back();
+            freeTraceBuffers.pop_back();
+        }
+        else
+        {
+            lease.buffer = &traceBuffers.emplace_back();
+            lease.buffer->capacity = std::max(1, traceBufferEvents);
+            lease.buffer->events.reset(new TraceEvent[lease.buffer->capacity]); // left uninitialized, pages are touched as events land
+        }
+    }
+    return *lease.buffer;
+}
+
+double traceNowUs()
+{
+    return simulationNowMs() * 1000.0 - traceEpochUs;
+}
+
+// Callers check traceEnabled first so a disabled trace costs one branch
+void recordTraceEvent(const char *name, char phase, double tsUs, double durUs, int pid, const char *argName, int arg,
+                      const char *end = nullptr, const std::string &label = "")
+{
+    TraceBuffer &buffer = localTraceBuffer();
+    int index = buffer.count.load(std::memory_order_relaxed);
+    if (index >= buffer.capacity)
+    {
+        buffer.dropped++;
+        return;
+    }
+    TraceEvent &event = buffer.events[index];
+    event.name = name;
+    event.phase = phase;
+    event.tid = traceTid;
+    event.tsUs = tsUs;
+    event.durUs = durUs;
+    event.pid = pid;
+    event.argName = argName;
+    event.arg = arg;
+    event.end = end;
+    size_t length = std::min(label.size(), sizeof(event.label) - 1);
+    std::memcpy(event.label, label.data(), length);
+    event.label[length] = '\0';
+    buffer.count.store(index + 1, std::memory_order_release);
+}
+
+void traceInstant(const char *name, int pid, const char *argName, int arg)
+{
+    recordTraceEvent(name, 'i', traceNowUs(), 0, pid, argName, arg);
+}
+
+// One slice of `proc` on the calling thread's core; `end` is quantum-expired, preempt, sleep, exit or shutdown
+void traceSlice(const ExecutableScreen &proc, double startMs, double endMs, int executed, const char *end)
+{
+    recordTraceEvent(nullptr, 'X', startMs * 1000.0 - traceEpochUs, (endMs - startMs) * 1000.0,
+                     proc.pid, "instructions", executed, end, proc.name);
+}
+
+// Arms tracing for a new run; called by initialize before any core starts
+void resetTrace()
+{
+    std::lock_guard<std::mutex> lock(traceBuffersMutex);
+    for (TraceBuffer &buffer : traceBuffers)
+    {
+        buffer.count.store(0, std::memory_order_relaxed);
+        buffer.dropped = 0;
+    }
+    traceEnabled = !traceFile.empty();
+    traceEpochUs = simulationNowMs() * 1000.0;
+}
+
+std::string traceThreadName(int tid)
+{
+    if (tid == TRACE_TID_GENERATOR)
+        return "process generator";
+    if (tid == TRACE_TID_SLEEP_TICKER)
+        return "sleep ticker";
+    if (tid < 0)
+        return "shell";
+    return "core " + std::to_string(tid);
+}
+
+// Writes every recorded event to trace-file as Chrome trace JSON and starts a fresh trace.
+// Only call once the cores and the generator have been joined so no thread is still appending.
+// Nothing is written when no thread recorded since the last write, so exit keeps scheduler-stop's trace.
+void writeTraceFile()
+{
+    if (!traceEnabled)
+        return;
+
+    std::lock_guard<std::mutex> lock(traceBuffersMutex);
+    bool recorded = false;
+    for (const TraceBuffer &buffer : traceBuffers)
+        recorded = recorded || buffer.count.load(std::memory_order_acquire) > 0 || buffer.dropped > 0;
+    if (!recorded)
+        return;
+    std::ofstream out(traceFile, std::ios::trunc);
+    if (!out)
+    {
+        std::cerr << "Error opening " << traceFile << "\n";
+        return;
+    }
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    std::set<int> tids;
+    long long written = 0;
+    long long dropped = 0;
+    for (const TraceBuffer &buffer : traceBuffers)
+    {
+        int count = buffer.count.load(std::memory_order_acquire);
+        dropped += buffer.dropped;
+        for (int i = 0; i < count; ++i)
+        {
+            const TraceEvent &e = buffer.events[i];
+            tids.insert(e.tid);
+            out << (written++ ? ",\n" : "")
+                << "{\"name\": \"" << jsonEscape(e.name ? e.name : e.label) << "\", \"ph\": \"" << e.phase
+                << "\", \"pid\": 0, \"tid\": " << e.tid << ", \"ts\": " << e.tsUs;
+            if (e.phase == 'X')
+                out << ", \"dur\": " << e.durUs;
+            else if (e.phase == 'i')
+                out << ", \"s\": \"t\"";
+            else
+                out << ", \"cat\": \"sleep\", \"id\": " << e.pid;
+            out << ", \"args\": {\"pid\": " << e.pid << ", \"" << e.argName << "\": " << e.arg;
+            if (e.end)
+                out << ", \"end\": \"" << e.end << "\"";
+            out << "}}";
+        }
+    }
+    for (int tid : tids)
+    {
+        out << (written++ ? ",\n" : "")
+            << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": " << tid
+            << ", \"args\": {\"name\": \"" << jsonEscape(traceThreadName(tid)) << "\"}}";
+    }
+    out << "\n]}\n";
+    std::cout << "Trace written to " << traceFile << " (" << written - static_cast<long long>(tids.size())
+              << " events, " << dropped << " dropped).\n";
+
+    for (TraceBuffer &buffer : traceBuffers)
+    {
+        buffer.count.store(0, std::memory_order_relaxed);
+        buffer.dropped = 0;
+    }
+}
+
+// Decides run order and preemption. Run queues are ordered by key(), lowest first, FIFO among equal keys.
+struct SchedulerPolicy
+{
+    virtual ~SchedulerPolicy() = default;
+    virtual std::string name() const = 0;
+    virtual long long key(const ExecutableScreen &) const { return 0; }
+    virtual int timeSlice(const ExecutableScreen &) const { return -1; } // -1 = run to completion
+    virtual bool preemptive() const { return false; }                    // yield when a lower key waits on the core
+    virtual void onSliceExpired(ExecutableScreen &) {}
+    virtual void onReady(ExecutableScreen &) {} // just before the process is keyed into a ready queue
+    virtual int boostTicks() const { return 0; } // instructions between boosts, 0 = never
+    virtual void boost() {}
+};
+
+struct FcfsScheduler : public SchedulerPolicy
+{
+    std::string name() const override { return "fcfs"; }
+};
+
+struct RoundRobinScheduler : public SchedulerPolicy
+{
+    std::string name() const override { return "rr"; }
+    int timeSlice(const ExecutableScreen &) const override { return std::max(1, quantum); }
+};
+
+// Preemptive priority; equal priorities share the core round-robin
+const int PRIORITY_LEVELS = 8;
+
+struct PriorityScheduler : public SchedulerPolicy
+{
+    std::string name() const override { return "priority"; }
+    long long key(const ExecutableScreen &proc) const override { return proc.priority; }
+    int timeSlice(const ExecutableScreen &) const override { return std::max(1, quantum); }
+    bool preemptive() const override { return true; }
+};
+
+// Non-preemptive shortest job first on the program length
+struct SjfScheduler : public SchedulerPolicy
+{
+    std::string name() const override { return "sjf"; }
+    long long key(const ExecutableScreen &proc) const override { return proc.totalLines; }
+};
+
+// Multi-level feedback queue: level n gets quantum << n and a process drops a level when it uses it all.
+// Every mlfq-boost-ticks instructions all processes go back to level 0, so a stream of new arrivals
+// cannot starve the lower levels; a process that is running or asleep at the boost picks it up when
+// it is next queued.
+const int MLFQ_LEVELS = 3;
+
+struct MlfqScheduler : public SchedulerPolicy
+{
+    std::atomic<int> epoch{0}; // boosts so far
+
+    std::string name() const override { return "mlfq"; }
+    long long key(const ExecutableScreen &proc) const override { return proc.queueLevel; }
+    int timeSlice(const ExecutableScreen &proc) const override { return std::max(1, quantum) << proc.queueLevel; }
+    bool preemptive() const override { return true; }
+    void onSliceExpired(ExecutableScreen &proc) override { proc.queueLevel = std::min(proc.queueLevel + 1, MLFQ_LEVELS - 1); }
+    void onReady(ExecutableScreen &proc) override
+    {
+        int current = epoch.load();
+        if (proc.boostEpoch != current)
+        {
+            proc.boostEpoch = current;
+            proc.queueLevel = 0;
+        }
+    }
+    int boostTicks() const override { return mlfqBoostTicks; }
+    void boost() override { epoch++; }
+};
+
+std::unique_ptr<SchedulerPolicy> makeSchedulerPolicy(const std::string &algo)
+{
+    if (algo == "fcfs")
+        return std::make_unique<FcfsScheduler>();
+    if (algo == "priority")
+        return std::make_unique<PriorityScheduler>();
+    if (algo == "sjf")
+        return std::make_unique<SjfScheduler>();
+    if (algo == "mlfq")
+        return std::make_unique<MlfqScheduler>();
+    if (algo != "rr")
+        std::cout << "Unknown scheduler " << algo << ", using rr.\n";
+    return std::make_unique<RoundRobinScheduler>();
+}
+
+std::unique_ptr<SchedulerPolicy> schedulerPolicy = makeSchedulerPolicy("rr");
+
+struct ReadyEntry
+{
+    long long key;
+    uint64_t seq; // enqueue order, breaks ties between equal keys
+    ExecutableScreen *proc;
+
+    bool operator<(const ReadyEntry &other) const
+    {
+        return key != other.key ? key < other.key : seq < other.seq;
+    }
+};
+
+// Per-core ready queue ordered by the scheduler policy; idle cores steal the head of other cores' queues
+struct RunQueue
+{
+    std::mutex mutex;
+    std::set<ReadyEntry> tasks;
+    std::atomic<int> size{0};                                              // read without the lock when placing work
+    std::atomic<long long> headKey{std::numeric_limits<long long>::max()}; // key of the head, for preemption checks
+};
+
+RunQueue runQueues[128];        // one per activePerCore slot
+std::atomic<int> readyCount{0}; // processes waiting in any run queue
+std::atomic<int> idleCores{0};  // workers parked on cv
+std::atomic<unsigned> nextPlacement{0};
+std::atomic<uint64_t> nextReadySeq{0};
+std::mutex queueMutex; // only for parking idle cores and stopScheduler
+std::condition_variable cv;
+bool stopScheduler = false;
+
+void wakeIdleCore()
+{
+    if (idleCores.load() == 0)
+        return;
+    // Taking the lock orders this with a core that is about to park
+    std::lock_guard<std::mutex> lock(queueMutex);
+    cv.notify_one();
+}
+
+// Queues a process on `coreId`, or on the least-loaded core when coreId is -1
+void enqueueReady(ExecutableScreen *proc, int coreId = -1)
+{
+    if (!proc->admitted)
+    {
+        proc->admitted = true;
+        proc->arrivalMs = simulationNowMs();
+        proc->priority = getRand(0, PRIORITY_LEVELS - 1);
+    }
+
+    int cores = std::max(1, std::min(CPU_CORES, 128));
+    if (coreId < 0 || coreId >= cores)
+    {
+        int start = static_cast<int>(nextPlacement++ % cores);
+        coreId = start;
+        for (int i = 1; i < cores && runQueues[coreId].size.load() > 0; ++i)
+        {
+            int candidate = (start + i) % cores;
+            if (runQueues[candidate].size.load() < runQueues[coreId].size.load())
+                coreId = candidate;
+        }
+    }
+
+    schedulerPolicy->onReady(*proc);
+    {
+        RunQueue &queue = runQueues[coreId];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.insert({schedulerPolicy->key(*proc), nextReadySeq++, proc});
+        queue.size++;
+        queue.headKey = queue.tasks.begin()->key;
+    }
+    readyCount++;
+    wakeIdleCore();
+}
+
+// Next process for `coreId`: the head of its own queue, else the head of another core's queue
+ExecutableScreen *takeReady(int coreId)
+{
+    if (readyCount.load() == 0)
+        return nullptr;
+
+    int cores = std::max(1, std::min(CPU_CORES, 128));
+    for (int i = 0; i < cores; ++i)
+    {
+        RunQueue &queue = runQueues[(coreId + i) % cores];
+        if (queue.size.load() == 0)
+            continue;
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty())
+            continue;
+        ExecutableScreen *proc = queue.tasks.begin()->proc;
+        queue.tasks.erase(queue.tasks.begin());
+        queue.size--;
+        queue.headKey = queue.tasks.empty() ? std::numeric_limits<long long>::max() : queue.tasks.begin()->key;
+        readyCount--;
+        return proc;
+    }
+    return nullptr;
+}
+
+// Applies a scheduler boost to every queued process and re-keys it; enqueue order is kept
+void boostReadyQueues()
+{
+    SchedulerPolicy &policy = *schedulerPolicy;
+    policy.boost();
+    int cores = std::max(1, std::min(CPU_CORES, 128));
+    for (int c = 0; c < cores; ++c)
+    {
+        RunQueue &queue = runQueues[c];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty())
+            continue;
+        std::set<ReadyEntry> boosted;
+        for (const ReadyEntry &entry : queue.tasks)
+        {
+            policy.onReady(*entry.proc);
+            boosted.insert({policy.key(*entry.proc), entry.seq, entry.proc});
+        }
+        queue.tasks.swap(boosted);
+        queue.headKey = queue.tasks.begin()->key;
+    }
+}
+
+// Hierarchical timing wheel for SLEEP. Level l has 64 slots of 64^l ticks each;
+// a higher-level slot is cascaded into the levels below when the lower levels wrap.
+struct TimerWheel
+{
+    static const int LEVELS = 4;
+    static const int SLOT_BITS = 6;
+    static const int SLOTS = 1 << SLOT_BITS;
+
+    struct Timer
+    {
+        uint64_t expiry;
+        ExecutableScreen *proc;
+    };
+
+    std::vector<Timer> slots[LEVELS][SLOTS];
+    uint64_t now = 0; // ticks advanced so far
+    int count = 0;
+
+    void add(ExecutableScreen *proc, uint64_t expiry)
+    {
+        place({std::max(expiry, now + 1), proc});
+        count++;
+    }
+
+    void place(const Timer &timer)
+    {
+        uint64_t delta = timer.expiry > now ? timer.expiry - now : 0;
+        int level = 0;
+        while (level < LEVELS - 1 && delta >= (1ull << (SLOT_BITS * (level + 1))))
+            level++;
+        slots[level][(timer.expiry >> (SLOT_BITS * level)) & (SLOTS - 1)].push_back(timer);
+    }
+
+    // Advances one tick and appends the processes whose sleep ended to `due`
+    void advance(std::vector<ExecutableScreen *> &due)
+    {
+        now++;
+        for (int level = 1; level < LEVELS; ++level)
+        {
+            if ((now & ((1ull << (SLOT_BITS * level)) - 1)) != 0)
+                break;
+            std::vector<Timer> cascaded;
+            cascaded.swap(slots[level][(now >> (SLOT_BITS * level)) & (SLOTS - 1)]);
+            for (const auto &timer : cascaded)
+                place(timer);
+        }
+
+        std::vector<Timer> &slot = slots[0][now & (SLOTS - 1)];
+        for (const auto &timer : slot)
+            due.push_back(timer.proc);
+        count -= static_cast<int>(slot.size());
+        slot.clear();
+    }
+};
+
+// A tick is delay-per-exec milliseconds; the ticker thread only runs while something sleeps
+TimerWheel sleepWheel;
+std::mutex sleepWheelMutex;
+std::condition_variable sleepWheelCv;
+std::atomic<int> sleepingCount{0}; // parked processes; workers keep running until this is 0 on stop
+std::thread sleepTickerThread;
+bool sleepTickerStop = false;
+
+// Releases the core: the process re-enters a run queue once `ticks` ticks have passed
+void parkSleepingProcess(ExecutableScreen *proc, int ticks)
+{
+    if (traceEnabled)
+        recordTraceEvent("SLEEP", 'b', traceNowUs(), 0, proc->pid, "ticks", ticks);
+    sleepingCount++;
+    {
+        std::lock_guard<std::mutex> lock(sleepWheelMutex);
+        sleepWheel.add(proc, sleepWheel.now + ticks);
+    }
+    sleepWheelCv.notify_one();
+}
+
+void startSleepTicker()
+{
+    if (sleepTickerThread.joinable())
+        return;
+    sleepTickerStop = false;
+    sleepTickerThread = std::thread([]
+                                    {
+        traceTid = TRACE_TID_SLEEP_TICKER;
+        std::unique_lock<std::mutex> lock(sleepWheelMutex);
+        while (!sleepTickerStop)
+        {
+            if (sleepWheel.count == 0)
+            {
+                sleepWheelCv.wait(lock, []
+                                  { return sleepTickerStop || sleepWheel.count > 0; });
+                continue;
+            }
+
+            auto nextTick = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(1, delayPerExec));
+            while (!sleepTickerStop && sleepWheel.count > 0)
+            {
+                if (sleepWheelCv.wait_until(lock, nextTick, []
+                                            { return sleepTickerStop; }))
+                    break;
+                nextTick += std::chrono::milliseconds(std::max(1, delayPerExec));
+
+                std::vector<ExecutableScreen *> due;
+                sleepWheel.advance(due);
+                if (due.empty())
+                    continue;
+
+                lock.unlock();
+                for (ExecutableScreen *proc : due)
+                {
+                    if (traceEnabled)
+                        recordTraceEvent("SLEEP", 'e', traceNowUs(), 0, proc->pid, "ticks", 0);
+                    enqueueReady(proc); // counted as ready before it stops counting as sleeping
+                }
+                if ((sleepingCount -= static_cast<int>(due.size())) == 0)
+                {
+                    std::lock_guard<std::mutex> queueLock(queueMutex);
+                    cv.notify_all(); // workers waiting for the last sleeper before stopping
+                }
+                lock.lock();
+            }
+        } });
+}
+
+void stopSleepTicker()
+{
+    if (!sleepTickerThread.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(sleepWheelMutex);
+        sleepTickerStop = true;
+    }
+    sleepWheelCv.notify_all();
+    sleepTickerThread.join();
+}
+
+// Averages over every process that exited under each scheduler, in milliseconds
+struct SchedulingStats
+{
+    int completed = 0;
+    double turnaroundMs = 0; // arrival to exit
+    double waitingMs = 0;    // turnaround minus time on a core
+    double responseMs = 0;   // arrival to first dispatch
+};
+std::map<std::string, SchedulingStats> schedulingStatsByPolicy;
+std::mutex schedulingStatsMutex;
+
+void recordCompletion(const ExecutableScreen &proc, const std::string &policyName)
+{
+    double turnaround = simulationNowMs() - proc.arrivalMs;
+    double waiting = std::max(0.0, turnaround - proc.cpuMs);
+    double response = proc.hasRun ? proc.firstRunMs - proc.arrivalMs : turnaround;
+
+    std::lock_guard<std::mutex> lock(schedulingStatsMutex);
+    SchedulingStats &stats = schedulingStatsByPolicy[policyName];
+    stats.completed++;
+    stats.turnaroundMs += turnaround;
+    stats.waitingMs += waiting;
+    stats.responseMs += response;
+}
+
+// Per-instruction logs are buffered in memory and appended to the files in batches
+std::vector<std::shared_ptr<ProcessLog>> processLogs;
+std::mutex processLogsMutex;
+std::mutex logWriteMutex; // keeps concurrent flushes of the same file in order
+std::thread logFlusherThread;
+std::mutex logFlusherMutex;
+std::condition_variable logFlusherCv;
+bool logFlusherStop = false;
+const int LOG_FLUSH_INTERVAL_MS = 100;
+
+// Called by the core that owns `proc`
+void appendProcessLog(ExecutableScreen &proc, time_t stamp, int coreId, std::string text)
+{
+    if (!logInstructions)
+        return;
+    if (!proc.log)
+    {
+        auto log = std::make_shared<ProcessLog>();
+        log->path = output_dir + "/" + proc.name + ".txt";
+        {
+            std::lock_guard<std::mutex> lock(processLogsMutex);
+            processLogs.push_back(log);
+        }
+        std::lock_guard<CopyableMutex> stateLock(proc.stateMutex);
+        proc.log = log;
+    }
+    std::lock_guard<std::mutex> lock(proc.log->mutex);
+    proc.log->pending.push_back({stamp, coreId, std::move(text)});
+}
+
+void closeProcessLog(ExecutableScreen &proc)
+{
+    if (!proc.log)
+        return;
+    std::lock_guard<std::mutex> lock(proc.log->mutex);
+    proc.log->closed = true;
+}
+
+// One open/write/close per file with pending lines
+void flushProcessLogs()
+{
+    std::lock_guard<std::mutex> writeLock(logWriteMutex);
+    std::vector<std::shared_ptr<ProcessLog>> logs;
+    {
+        std::lock_guard<std::mutex> lock(processLogsMutex);
+        logs = processLogs;
+    }
+
+    bool anyClosed = false;
+    for (auto &log : logs)
+    {
+        std::vector<LogRecord> batch;
+        {
+            std::lock_guard<std::mutex> lock(log->mutex);
+            batch.swap(log->pending);
+            anyClosed = anyClosed || log->closed;
+        }
+        if (batch.empty())
+            continue;
+        std::ofstream outFile(log->path, std::ios::app);
+        if (!outFile.is_open())
+            continue;
+        for (const auto &record : batch)
+            outFile << "(" << formatTimestamp(record.stamp) << ") Core:" << record.coreId << " " << record.text << "\n";
+    }
+
+    if (anyClosed)
+    {
+        std::lock_guard<std::mutex> lock(processLogsMutex);
+        processLogs.erase(std::remove_if(processLogs.begin(), processLogs.end(),
+                                         [](const std::shared_ptr<ProcessLog> &log)
+                                         {
+                                             std::lock_guard<std::mutex> logLock(log->mutex);
+                                             return log->closed && log->pending.empty();
+                                         }),
+                          processLogs.end());
+    }
+}
+
+void startLogFlusher()
+{
+    if (logFlusherThread.joinable())
+        return;
+    logFlusherStop = false;
+    logFlusherThread = std::thread([]
+                                   {
+        std::unique_lock<std::mutex> lock(logFlusherMutex);
+        while (!logFlusherStop)
+        {
+            logFlusherCv.wait_for(lock, std::chrono::milliseconds(LOG_FLUSH_INTERVAL_MS));
+            lock.unlock();
+            flushProcessLogs();
+            lock.lock();
+        } });
+}
+
+// Joins the flusher and writes whatever is still buffered
+void stopLogFlusher()
+{
+    if (logFlusherThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(logFlusherMutex);
+            logFlusherStop = true;
+        }
+        logFlusherCv.notify_all();
+        logFlusherThread.join();
+    }
+    flushProcessLogs();
+}
+
+// Memory snapshots are captured by the cores and written by a background thread
+struct MemorySnapshot
+{
+    int id;
+    time_t stamp;
+    int memTotal;
+    std::vector<MemoryBlock> blocks;
+};
+
+const std::string SNAPSHOT_STREAM_FILE = "memory_stamps.bin";
+const size_t MAX_PENDING_SNAPSHOTS = 256; // beyond this the oldest pending snapshot is dropped rather than block a core
+
+std::atomic<int> snapshotCounter{0};
+std::atomic<int> snapshotsDropped{0}; // superseded by newer ones while the writer was a full queue behind; shown by vmstat
+std::deque<MemorySnapshot> pendingSnapshots;
+std::mutex snapshotMutex;
+std::condition_variable snapshotCv;
+std::thread snapshotWriterThread;
+bool snapshotWriterStop = false;
+
+// Called by a core after every instruction; only copies the block list when a snapshot is due
+void recordInstructionForSnapshot()
+{
+    int id = ++snapshotCounter;
+    int interval = snapshotInterval > 0 ? snapshotInterval : quantum;
+    if (interval <= 0 || id % interval != 0)
+        return;
+
+    MemorySnapshot snap{id, time(nullptr), MEM_TOTAL, snapshotMemoryBlocks()};
+    {
+        std::lock_guard<std::mutex> lock(snapshotMutex);
+        if (pendingSnapshots.size() >= MAX_PENDING_SNAPSHOTS)
+        {
+            pendingSnapshots.pop_front(); // keep the newest memory layout
+            snapshotsDropped++;
+        }
+        pendingSnapshots.push_back(std::move(snap));
+    }
+    snapshotCv.notify_one();
+}
+
+void writeTextSnapshot(const MemorySnapshot &snapshot)
+{
+    const std::vector<MemoryBlock> &memoryBlocks = snapshot.blocks;
+    std::ofstream snap("memory_stamp_" + std::to_string(snapshot.id) + ".txt");
+    snap << "Timestamp: (" << formatTimestamp(snapshot.stamp) << ")\n";
+
+    int inMemCount = 0;
+    for (const auto &b : memoryBlocks)
+        if (!b.owner.empty())
+            inMemCount++;
+    snap << "Number of processes in memory: " << inMemCount << "\n";
+
+    int externalFrag = 0;
+    for (const auto &b : memoryBlocks)
+        if (b.owner.empty())
+            externalFrag += b.size;
+    snap << "Total external fragmentation in KB: " << externalFrag / 1024 << "\n\n";
+
+    snap << "----end---- = " << snapshot.memTotal << "\n";
+    int cur = snapshot.memTotal;
+    for (auto it = memoryBlocks.rbegin(); it != memoryBlocks.rend(); ++it)
+    {
+        if (!it->owner.empty())
+        {
+            snap << cur << "\n"
+                 << it->owner << "\n"
+                 << (cur - it->size) << "\n";
+        }
+        cur -= it->size;
+    }
+    snap << "----start---- = 0\n";
+}
+
+// Record layout: int32 id, int64 stamp, int32 memTotal, int32 blockCount,
+// then per block int32 start, int32 size, uint16 owner length, owner bytes
+void writeBinarySnapshot(std::ofstream &stream, const MemorySnapshot &snapshot)
+{
+    int32_t id = snapshot.id;
+    int64_t stamp = snapshot.stamp;
+    int32_t memTotal = snapshot.memTotal;
+    int32_t blockCount = static_cast<int32_t>(snapshot.blocks.size());
+    stream.write(reinterpret_cast<const char *>(&id), sizeof(id));
+    stream.write(reinterpret_cast<const char *>(&stamp), sizeof(stamp));
+    stream.write(reinterpret_cast<const char *>(&memTotal), sizeof(memTotal));
+    stream.write(reinterpret_cast<const char *>(&blockCount), sizeof(blockCount));
+    for (const auto &b : snapshot.blocks)
+    {
+        int32_t start = b.start;
+        int32_t size = b.size;
+        uint16_t ownerLength = static_cast<uint16_t>(b.owner.size());
+        stream.write(reinterpret_cast<const char *>(&start), sizeof(start));
+        stream.write(reinterpret_cast<const char *>(&size), sizeof(size));
+        stream.write(reinterpret_cast<const char *>(&ownerLength), sizeof(ownerLength));
+        stream.write(b.owner.data(), ownerLength);
+    }
+}
+
+void startSnapshotWriter()
+{
+    if (snapshotWriterThread.joinable())
+        return;
+    snapshotWriterStop = false;
+    snapshotCounter = 0;
+    snapshotsDropped = 0;
+    snapshotWriterThread = std::thread([]
+                                       {
+        std::ofstream stream;
+        if (snapshotFormat == "binary")
+            stream.open(SNAPSHOT_STREAM_FILE, std::ios::binary | std::ios::trunc);
+
+        std::unique_lock<std::mutex> lock(snapshotMutex);
+        while (true)
+        {
+            snapshotCv.wait(lock, []
+                            { return !pendingSnapshots.empty() || snapshotWriterStop; });
+            if (pendingSnapshots.empty())
+                break; // stop requested and everything is written
+
+            std::deque<MemorySnapshot> batch;
+            batch.swap(pendingSnapshots);
+            lock.unlock();
+            for (const auto &snapshot : batch)
+            {
+                if (stream.is_open())
+                    writeBinarySnapshot(stream, snapshot);
+                else
+                    writeTextSnapshot(snapshot);
+            }
+            if (stream.is_open())
+                stream.flush();
+            lock.lock();
+        } });
+}
+
+// Writes the remaining snapshots and joins the writer
+void stopSnapshotWriter()
+{
+    if (!snapshotWriterThread.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(snapshotMutex);
+        snapshotWriterStop = true;
+    }
+    snapshotCv.notify_all();
+    snapshotWriterThread.join();
+}
+
+void resetFreeFrames()
+{
+    freeFrameHead = frameTable.empty() ? -1 : 0;
+    freeFrameCount = static_cast<int>(frameTable.size());
+    for (int i = 0; i < (int)frameTable.size(); ++i)
+        frameTable[i].nextFree = (i + 1 < (int)frameTable.size()) ? i + 1 : -1;
+}
 
-    // Write to backing store (simulate swap out)
-    std::ofstream backingFile("csopesy-backing-store.txt", std::ios::app);
-    backingFile << procName << " " << virtualPage << " ";
-    int baseAddr = victimFrame * MEM_FRAME_SIZE;
-    for (int i = 0; i < MEM_FRAME_SIZE; ++i)
+int findFreeFrame()
+{
+    int frame = freeFrameHead;
+    if (frame != -1)
     {
-        std::string addr = "0x" + std::to_string(baseAddr + i);
-        uint16_t val = 0;
+        freeFrameHead = frameTable[frame].nextFree;
+        frameTable[frame].nextFree = -1;
+        freeFrameCount--;
+    }
+    return frame;
+}
+
+void releaseFrame(int frame)
+{
+    FrameTableEntry &entry = frameTable[frame];
+    entry.occupied = false;
+    entry.owner = nullptr;
+    entry.pageEntry = nullptr;
+    entry.virtualPageNumber = -1;
+    entry.referenced = false;
+    entry.age = 0;
+    entry.nextFree = freeFrameHead;
+    freeFrameHead = frame;
+    freeFrameCount++;
+}
+
+uint16_t *frameData(int frameNum)
+{
+    return physicalMemory.data() + static_cast<size_t>(frameNum) * MEM_FRAME_SIZE;
+}
+
+// Binary swap file: one fixed-size slot of MEM_FRAME_SIZE words per (process, virtual page)
+const std::string BACKING_STORE_FILE = "csopesy-backing-store.bin";
+const std::string BACKING_STORE_DUMP_FILE = "csopesy-backing-store.txt";
+
+struct BackingStoreSlot
+{
+    std::string ownerProcess; // only kept for the text dump
+    int virtualPageNumber = -1;
+    bool inUse = false;
+};
+
+std::fstream backingStoreFile;
+std::unordered_map<uint64_t, int> backingStoreIndex; // key = pageKey(pid, virtual page)
+std::vector<BackingStoreSlot> backingStoreSlots;
+std::vector<int> freeBackingStoreSlots;
+std::mutex backingStoreMutex;
+
+std::streamoff backingStoreOffset(int slot)
+{
+    return static_cast<std::streamoff>(slot) * MEM_FRAME_SIZE * sizeof(uint16_t);
+}
+
+void resetBackingStore()
+{
+    std::lock_guard<std::mutex> lock(backingStoreMutex);
+    if (backingStoreFile.is_open())
+        backingStoreFile.close();
+    backingStoreFile.open(BACKING_STORE_FILE, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!backingStoreFile.is_open())
+        std::cerr << "Error opening " << BACKING_STORE_FILE << "\n";
+    backingStoreIndex.clear();
+    backingStoreSlots.clear();
+    freeBackingStoreSlots.clear();
+}
+
+void writePageToBackingStore(int pid, const std::string &procName, int virtualPage, const uint16_t *data)
+{
+    std::lock_guard<std::mutex> lock(backingStoreMutex);
+    int slot;
+    auto it = backingStoreIndex.find(pageKey(pid, virtualPage));
+    if (it != backingStoreIndex.end())
+    {
+        slot = it->second; // overwrite the stale copy in place
+    }
+    else
+    {
+        if (!freeBackingStoreSlots.empty())
         {
-            std::lock_guard<std::mutex> lock(physicalMemoryMutex);
-            if (physicalMemory.count(addr))
-            {
-                val = physicalMemory[addr];
-            }
+            slot = freeBackingStoreSlots.back();
+            freeBackingStoreSlots.pop_back();
+        }
+        else
+        {
+            slot = static_cast<int>(backingStoreSlots.size());
+            backingStoreSlots.emplace_back();
         }
-        backingFile << val << " ";
+        backingStoreSlots[slot] = {procName, virtualPage, true};
+        backingStoreIndex[pageKey(pid, virtualPage)] = slot;
     }
-    backingFile << "\n";
 
-    pagesPagedOut++;
+    backingStoreFile.seekp(backingStoreOffset(slot));
+    backingStoreFile.write(reinterpret_cast<const char *>(data), MEM_FRAME_SIZE * sizeof(uint16_t));
+    backingStoreFile.flush();
+}
+
+bool restorePageFromBackingStore(int pid, int virtualPage, int frameNum)
+{
+    std::lock_guard<std::mutex> lock(backingStoreMutex);
+    auto it = backingStoreIndex.find(pageKey(pid, virtualPage));
+    if (it == backingStoreIndex.end())
+        return false;
+
+    // The frame is not mapped yet, so nobody else can observe the partial read
+    backingStoreFile.seekg(backingStoreOffset(it->second));
+    backingStoreFile.read(reinterpret_cast<char *>(frameData(frameNum)), MEM_FRAME_SIZE * sizeof(uint16_t));
+    if (!backingStoreFile)
+    {
+        backingStoreFile.clear();
+        return false;
+    }
+    return true;
+}
+
+bool readWordFromBackingStore(int pid, int virtualPage, int offset, uint16_t &value)
+{
+    std::lock_guard<std::mutex> lock(backingStoreMutex);
+    auto it = backingStoreIndex.find(pageKey(pid, virtualPage));
+    if (it == backingStoreIndex.end())
+        return false;
 
-    // Update victim process page table
-    std::queue<ExecutableScreen *> tempQueue;
+    backingStoreFile.seekg(backingStoreOffset(it->second) + offset * static_cast<std::streamoff>(sizeof(uint16_t)));
+    backingStoreFile.read(reinterpret_cast<char *>(&value), sizeof(value));
+    if (!backingStoreFile)
+    {
+        backingStoreFile.clear();
+        return false;
+    }
+    return true;
+}
 
-    while (!readyQueue.empty())
+// Returns the swap slots of an exited process to the free list
+void releaseBackingStore(const ExecutableScreen &proc)
+{
+    std::lock_guard<std::mutex> lock(backingStoreMutex);
+    for (int page = 0; page < (int)proc.pageTable.size(); ++page)
     {
-        ExecutableScreen *s = readyQueue.front();
-        readyQueue.pop();
+        auto it = backingStoreIndex.find(pageKey(proc.pid, page));
+        if (it == backingStoreIndex.end())
+            continue;
+        backingStoreSlots[it->second].inUse = false;
+        freeBackingStoreSlots.push_back(it->second);
+        backingStoreIndex.erase(it);
+    }
+}
 
-        if (s->name == procName)
+// Writes every live slot in the old "<process> <page> <words...>" text format for debugging
+int dumpBackingStore(const std::string &filename)
+{
+    std::lock_guard<std::mutex> lock(backingStoreMutex);
+    std::ofstream out(filename);
+    std::vector<uint16_t> page(MEM_FRAME_SIZE);
+    int dumped = 0;
+    for (int slot = 0; slot < (int)backingStoreSlots.size(); ++slot)
+    {
+        const auto &info = backingStoreSlots[slot];
+        if (!info.inUse)
+            continue;
+        backingStoreFile.seekg(backingStoreOffset(slot));
+        backingStoreFile.read(reinterpret_cast<char *>(page.data()), MEM_FRAME_SIZE * sizeof(uint16_t));
+        if (!backingStoreFile)
         {
-            s->pageTable[virtualPage].present = false;
-            s->pageTable[virtualPage].frameNumber = -1;
+            backingStoreFile.clear();
+            continue;
         }
+        out << info.ownerProcess << " " << info.virtualPageNumber << " ";
+        for (uint16_t val : page)
+            out << val << " ";
+        out << "\n";
+        dumped++;
+    }
+    return dumped;
+}
+
+// Caller holds pagerMutex, and the faulting process's pageTableMutex when that process is `self`
+int evictPageAndReturnFrame(const ExecutableScreen *self)
+{
+    int victimFrame = replacementPolicy->selectVictim();
+    if (victimFrame == -1)
+        return -1; // no pages to evict
+
+    FrameTableEntry &victim = frameTable[victimFrame];
+    int virtualPage = victim.virtualPageNumber;
 
-        tempQueue.push(s); // requeue
+    // Wait for the owner to unpin the page before its frame is taken away
+    std::unique_lock<CopyableMutex> ownerLock(victim.owner->pageTableMutex, std::defer_lock);
+    if (victim.owner != self)
+        ownerLock.lock();
+    if (traceEnabled)
+        traceInstant(victim.pageEntry->dirty ? "evict (dirty)" : "evict (clean)", victim.owner->pid, "page", virtualPage);
+
+    // Only modified pages need a write-out; a clean page already matches its
+    // swap copy, or is an untouched zero page that is rebuilt on the next fault
+    if (victim.pageEntry->dirty)
+    {
+        writePageToBackingStore(victim.owner->pid, victim.owner->name, virtualPage, frameData(victimFrame));
+        pagesWrittenBack++;
     }
+    else
+    {
+        pagesDroppedClean++;
+    }
+
+    pagesPagedOut++;
 
-    // Restore original queue
-    readyQueue = tempQueue;
+    // Invalidate the victim's page table entry through the reverse mapping
+    victim.pageEntry->present = false;
+    victim.pageEntry->frameNumber = -1;
+    victim.pageEntry->dirty = false;
 
     // Mark frame as free
     victim.occupied = false;
-    victim.ownerProcess = "";
+    victim.owner = nullptr;
+    victim.pageEntry = nullptr;
     victim.virtualPageNumber = -1;
+    victim.referenced = false;
+    victim.age = 0;
 
     return victimFrame;
 }
 
+// Caller holds pagerMutex and proc.pageTableMutex
 void loadPageIntoFrame(ExecutableScreen &proc, int virtualPage)
 {
+    if (traceEnabled)
+        traceInstant("page-fault", proc.pid, "page", virtualPage);
     int frame = findFreeFrame();
     if (frame == -1)
     {
-        frame = evictPageAndReturnFrame();
+        frame = evictPageAndReturnFrame(&proc);
         if (frame == -1)
         {
             std::cout << "ERROR: No frame available for loading page.\n";
@@ -452,295 +2407,506 @@ void loadPageIntoFrame(ExecutableScreen &proc, int virtualPage)
     }
 
     // Load the page into frame
+    auto &entry = proc.pageTable[virtualPage];
     frameTable[frame].occupied = true;
-    frameTable[frame].ownerProcess = proc.name;
+    frameTable[frame].owner = &proc;
+    frameTable[frame].pageEntry = &entry;
     frameTable[frame].virtualPageNumber = virtualPage;
-    restorePageFromBackingStore(proc.name, virtualPage, frame);
+    frameTable[frame].loadStamp++;
+    if (!restorePageFromBackingStore(proc.pid, virtualPage, frame))
+    {
+        // First touch: hand out a zeroed frame instead of the previous owner's data
+        std::fill(frameData(frame), frameData(frame) + MEM_FRAME_SIZE, 0);
+    }
 
-    fifoFrameQueue.push(frame);
+    replacementPolicy->onLoad(frame);
 
     // Update page table
-    proc.pageTable[virtualPage].present = true;
-    proc.pageTable[virtualPage].frameNumber = frame;
+    entry.present = true;
+    entry.frameNumber = frame;
+    entry.dirty = false; // frame matches the swap copy until the next WRITE/DECLARE
 
     pagesPagedIn++;
 }
 
-bool ensurePageLoaded(ExecutableScreen &proc, int memoryAddress)
+std::mutex pageTraceMutex;
+
+// Makes the page resident and returns the physical word index of `memoryAddress`, or -1.
+// On success `pin` holds proc.pageTableMutex so the frame cannot be evicted until it is released.
+// Hits only take the process's own lock; faults fall back to the global pager lock.
+int pinPage(ExecutableScreen &proc, int memoryAddress, bool isWrite, std::unique_lock<CopyableMutex> &pin)
 {
     int virtualPage = memoryAddress / MEM_FRAME_SIZE;
+    pin = std::unique_lock<CopyableMutex>(proc.pageTableMutex);
 
     if (!proc.pageTable[virtualPage].present)
     {
-        // Page fault: load it in
-        loadPageIntoFrame(proc, virtualPage);
-        return true; // page was loaded
+        // Page fault: drop the pin so the pager lock is always taken first
+        pin.unlock();
+        std::lock_guard<std::mutex> pagerLock(pagerMutex);
+        pin.lock();
+        if (!proc.pageTable[virtualPage].present)
+            loadPageIntoFrame(proc, virtualPage);
+    }
+
+    auto &entry = proc.pageTable[virtualPage];
+    pageAccesses++;
+    if (pageTraceOut.is_open())
+    {
+        uint64_t key = pageKey(proc.pid, virtualPage);
+        std::lock_guard<std::mutex> lock(pageTraceMutex);
+        pageTraceOut.write(reinterpret_cast<const char *>(&key), sizeof(key));
     }
-    return false; // already present
+    if (!entry.present)
+        return -1;
+
+    frameTable[entry.frameNumber].referenced = true;
+    if (isWrite)
+        entry.dirty = true;
+    replacementPolicy->onAccess(entry.frameNumber);
+    return entry.frameNumber * MEM_FRAME_SIZE + memoryAddress % MEM_FRAME_SIZE;
 }
 
-void cpuWorker(int coreId)
+bool readMemoryWord(ExecutableScreen &proc, int memoryAddress, uint16_t &value)
 {
-    while (true)
+    std::unique_lock<CopyableMutex> pin;
+    int physAddr = pinPage(proc, memoryAddress, false, pin);
+    if (physAddr == -1)
+        return false;
+    value = physicalMemory[physAddr];
+    return true;
+}
+
+bool writeMemoryWord(ExecutableScreen &proc, int memoryAddress, uint16_t value)
+{
+    std::unique_lock<CopyableMutex> pin;
+    int physAddr = pinPage(proc, memoryAddress, true, pin);
+    if (physAddr == -1)
+        return false;
+    physicalMemory[physAddr] = value;
+    return true;
+}
+
+// Reads a word for display without faulting: resident frame, else swap copy, else zero
+uint16_t peekMemoryWord(const ExecutableScreen &proc, int memoryAddress)
+{
+    int virtualPage = memoryAddress / MEM_FRAME_SIZE;
+    int offset = memoryAddress % MEM_FRAME_SIZE;
+    if (virtualPage >= (int)proc.pageTable.size())
+        return 0;
+    std::lock_guard<CopyableMutex> pin(proc.pageTableMutex);
+    const auto &entry = proc.pageTable[virtualPage];
+    if (entry.present)
+        return physicalMemory[entry.frameNumber * MEM_FRAME_SIZE + offset];
+    uint16_t value = 0;
+    readWordFromBackingStore(proc.pid, virtualPage, offset, value);
+    return value;
+}
+
+// Variables live in the symbol table at the start of the process: slot s is the word at address s * 2
+int symbolTableCapacity(const ExecutableScreen &proc)
+{
+    return std::min(SYMBOL_TABLE_BYTES, proc.memorySize) / 2;
+}
+
+uint16_t readVariable(ExecutableScreen &proc, uint16_t slot)
+{
+    uint16_t value = 0;
+    if (proc.memory.isDeclared(slot))
+        readMemoryWord(proc, slot * 2, value);
+    return value;
+}
+
+uint16_t readOperand(ExecutableScreen &proc, uint16_t slot, uint16_t imm)
+{
+    return slot == NO_SLOT ? imm : readVariable(proc, slot);
+}
+
+bool writeVariable(ExecutableScreen &proc, uint16_t slot, uint16_t value)
+{
+    if (slot >= symbolTableCapacity(proc) || !writeMemoryWord(proc, slot * 2, value))
+        return false;
+    proc.memory.declared |= 1u << slot;
+    return true;
+}
+
+// Current value of every symbol table slot, read through the process's own page table
+std::vector<uint16_t> captureVariables(const ExecutableScreen &proc)
+{
+    std::vector<uint16_t> values;
+    for (int slot = 0; slot < symbolTableCapacity(proc); ++slot)
+        values.push_back(proc.memory.isDeclared(slot) ? peekMemoryWord(proc, slot * 2) : 0);
+    return values;
+}
+
+// Returns every resident page of an exited process to the free frame list
+void releaseProcessFrames(ExecutableScreen &proc)
+{
+    // Keep the variables readable by screen -r once the pages are gone
+    proc.memory.finalValues = captureVariables(proc);
+
+    std::lock_guard<std::mutex> pagerLock(pagerMutex);
+    std::lock_guard<CopyableMutex> pin(proc.pageTableMutex);
+    for (auto &entry : proc.pageTable)
     {
-        std::unique_lock<std::mutex> lock(queueMutex);
-        cv.wait(lock, []
-                { return !readyQueue.empty() || stopScheduler; });
+        if (!entry.present)
+            continue;
+        releaseFrame(entry.frameNumber);
+        entry.present = false;
+        entry.frameNumber = -1;
+        entry.dirty = false;
+    }
+}
 
-        if (stopScheduler && readyQueue.empty())
-            return;
+// Consistent copy of a process that a core may be executing right now
+// The copy's page table goes stale as soon as the lock drops, so its variables are read now
+// from the live process and printScreen only ever shows these captured values
+ExecutableScreen snapshotScreen(const ExecutableScreen &screen)
+{
+    std::lock_guard<CopyableMutex> stateLock(screen.stateMutex);
+    ExecutableScreen copy = screen;
+    if (copy.memory.finalValues.empty())
+        copy.memory.finalValues = captureVariables(screen);
+    return copy;
+}
 
-        if (readyQueue.empty())
+void printScreen(const ExecutableScreen &screen)
+{
+    std::cout << "Screen Title: " << screen.name << "\n";
+    std::cout << "Current Line: " << screen.currentLine << "/" << screen.totalLines << "\n";
+    std::cout << "Created Date: " << screen.createdDate << "\n";
+    std::cout << "Variables:\n";
+    for (size_t slot = 0; slot < screen.program->slotNames.size(); ++slot)
+    {
+        if (screen.memory.isDeclared(static_cast<uint16_t>(slot)))
         {
-            idleTicks++;
-            totalTicks++;
-            continue;
+            uint16_t value = slot < screen.memory.finalValues.size() ? screen.memory.finalValues[slot] : 0;
+            std::cout << "  " << screen.program->slotNames[slot] << " = " << value << "\n";
         }
+    }
+    if (!screen.consoleOutput.empty())
+    {
+        std::cout << "Console Output:\n";
+        if (screen.consoleOutput.dropped > 0)
+            std::cout << "  (" << screen.consoleOutput.dropped << " earlier lines dropped)\n";
+        screen.consoleOutput.forEach([](const std::string &line)
+                                     { std::cout << "  " << line << "\n"; });
+    }
+}
 
-        ExecutableScreen *execScreen = readyQueue.front();
-        readyQueue.pop();
-        lock.unlock();
+void printSummary(const ProcessSummary &summary)
+{
+    std::cout << "Screen Title: " << summary.name << "\n";
+    std::cout << "Current Line: " << summary.currentLine << "/" << summary.totalLines << "\n";
+    std::cout << "Created Date: " << summary.createdDate << "\n";
+    std::cout << "Finished: " << summary.finishedTime << "\n";
+    std::cout << "(Variables and console output were released by the retention policy.)\n";
+}
 
-        if (!execScreen)
-            continue;
-        activePerCore[coreId] = execScreen;
+// Runs the instruction at proc.instructionPointer and advances it; the caller holds proc.stateMutex.
+// The log line is only built when logEntry is non-null. Returns false when an access violation shut
+// the process down.
+bool executeInstruction(ExecutableScreen &proc, int coreId, std::string *logEntry, int &sleepTicks)
+{
+    const Program &program = *proc.program;
+    ProcessMemory &mem = proc.memory;
+    const Bytecode &inst = program.code[proc.instructionPointer];
 
-        if (schedulerAlgo == "rr")
+    switch (inst.type)
+    {
+    case InstructionType::DECLARE:
+    {
+        int maxVars = symbolTableCapacity(proc);
+        if (inst.dst >= maxVars)
         {
-            int slice = quantum;
-            while (slice > 0 && execScreen->instructionPointer < (int)execScreen->instructions.size())
-            {
-                std::lock_guard<std::mutex> lock(screensMutex);
-                Instruction &inst = execScreen->instructions[execScreen->instructionPointer];
+            if (logEntry)
+                *logEntry = "DECLARE skipped: symbol table full (" + std::to_string(maxVars) + " vars max).";
+            break;
+        }
 
-                std::string logEntry;
+        if (!writeVariable(proc, inst.dst, inst.imm1))
+        {
+            if (logEntry)
+                *logEntry = "DECLARE failed: could not load symbol table page.";
+            break;
+        }
 
-                switch (inst.type)
-                {
-                case InstructionType::DECLARE:
-                {
-                    size_t maxVars = execScreen->memorySize / 2;
-                    if (execScreen->memory.vars.size() >= maxVars)
-                    {
-                        logEntry = "DECLARE skipped: symbol table full (" + std::to_string(maxVars) + " vars max).";
-                        break;
-                    }
+        if (logEntry)
+            *logEntry = "DECLARE " + program.slotNames[inst.dst] + " at address " + std::to_string(inst.dst * 2);
+        break;
+    }
+    case InstructionType::PRINT:
+    {
+        std::string &output = proc.consoleOutput.nextLine();
+        appendPrintText(output, program.strings[inst.text], proc.name);
+        if (inst.src1 != NO_SLOT)
+        {
+            if (mem.isDeclared(inst.src1))
+                appendNumber(output, readVariable(proc, inst.src1));
+            else
+                output.append("[undefined var: ").append(program.slotNames[inst.src1]).append("]");
+        }
+        if (logEntry)
+            *logEntry = output;
+        break;
+    }
+    case InstructionType::ADD:
+    case InstructionType::SUBTRACT:
+    {
+        bool isAdd = inst.type == InstructionType::ADD;
+        uint16_t a = readOperand(proc, inst.src1, inst.imm1);
+        uint16_t b = readOperand(proc, inst.src2, inst.imm2);
+        uint16_t result = isAdd ? a + b : a - b;
+        if (!writeVariable(proc, inst.dst, result))
+        {
+            if (logEntry)
+                *logEntry = std::string(isAdd ? "ADD" : "SUBTRACT") + " failed: symbol table full.";
+            break;
+        }
+        if (logEntry)
+            *logEntry = (isAdd ? "Added: " : "Subtracted: ") + program.slotNames[inst.dst] + " = " + std::to_string(result);
+        break;
+    }
+    case InstructionType::SLEEP:
+    {
+        sleepTicks = inst.imm1;
+        if (logEntry)
+            *logEntry = "Slept for " + std::to_string(inst.imm1) + " ticks.";
+        break;
+    }
+    case InstructionType::WRITE:
+    {
+        const std::string &address = program.strings[inst.text];
+        int addr = inst.address;
 
-                    int varOffset = execScreen->memory.vars.size() * 2;
-                    int symbolTableAddress = varOffset;
+        if (addr == -1 || !isValidMemoryAccess(proc, addr))
+        {
+            shutdownProcess(proc, address);
+            return false;
+        }
 
-                    if (symbolTableAddress >= execScreen->memorySize)
-                    {
-                        logEntry = "DECLARE failed: symbol table overflow.";
-                        break;
-                    }
+        uint16_t val = inst.imm1;
+        if (inst.src1 != NO_SLOT)
+        {
+            if (!mem.isDeclared(inst.src1))
+            {
+                if (logEntry)
+                    *logEntry = "WRITE failed: value not found.";
+                break;
+            }
+            val = readVariable(proc, inst.src1);
+        }
 
-                    if (!ensurePageLoaded(*execScreen, symbolTableAddress))
-                    {
-                        logEntry = "DECLARE failed: could not load symbol table page.";
-                        break;
-                    }
+        if (!writeMemoryWord(proc, addr, val))
+        {
+            if (logEntry)
+                *logEntry = "WRITE failed: could not load page.";
+            break;
+        }
 
-                    execScreen->memory.vars[inst.var1] = varOffset;
-                    logEntry = "DECLARE " + inst.var1 + " at address " + std::to_string(varOffset);
-                    break;
-                }
-                case InstructionType::PRINT:
-                {
-                    std::ostringstream log;
-                    log << inst.message;
-                    if (!inst.var1.empty())
-                    {
-                        auto it = execScreen->memory.vars.find(inst.var1);
-                        log << (it != execScreen->memory.vars.end()
-                                    ? std::to_string(it->second)
-                                    : "[undefined var: " + inst.var1 + "]");
-                    }
-                    std::string output = log.str();
-                    execScreen->consoleOutput.push_back(output);
-                    logEntry = output;
-                    break;
-                }
-                case InstructionType::ADD:
-                {
-                    uint16_t a = execScreen->memory.vars[inst.var2];
-                    uint16_t b = execScreen->memory.vars[inst.var3];
-                    execScreen->memory.vars[inst.var1] = a + b;
-                    logEntry = "Added: " + inst.var1 + " = " + std::to_string(execScreen->memory.vars[inst.var1]);
-                    break;
-                }
-                case InstructionType::SUBTRACT:
-                {
-                    uint16_t a = execScreen->memory.vars[inst.var2];
-                    uint16_t b = execScreen->memory.vars[inst.var3];
-                    execScreen->memory.vars[inst.var1] = a - b;
-                    logEntry = "Subtracted: " + inst.var1 + " = " + std::to_string(execScreen->memory.vars[inst.var1]);
-                    break;
-                }
-                case InstructionType::SLEEP:
-                {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(inst.sleepTicks * delayPerExec));
-                    logEntry = "Slept for " + std::to_string(inst.sleepTicks) + " ticks.";
-                    break;
-                }
-                case InstructionType::WRITE:
-                {
-                    std::string address = inst.var1;
-                    std::string valRef = inst.var2;
+        if (logEntry)
+            *logEntry = "Wrote value " + std::to_string(val) + " to " + address;
+        break;
+    }
+    case InstructionType::READ:
+    {
+        const std::string &address = program.strings[inst.text];
+        int addr = inst.address;
 
-                    int addr = 0;
-                    try
-                    {
-                        addr = std::stoi(address, nullptr, 16);
-                    }
-                    catch (...)
-                    {
-                        shutdownProcess(*execScreen, address);
-                        goto next_process;
-                    }
+        if (addr == -1 || !isValidMemoryAccess(proc, addr))
+        {
+            shutdownProcess(proc, address);
+            return false;
+        }
 
-                    if (addr < 0 || addr >= MEM_TOTAL)
-                    {
-                        shutdownProcess(*execScreen, address);
-                        goto next_process;
-                    }
+        uint16_t val = 0;
+        readMemoryWord(proc, addr, val);
+        if (!writeVariable(proc, inst.dst, val))
+        {
+            if (logEntry)
+                *logEntry = "READ failed: symbol table full.";
+            break;
+        }
+        if (logEntry)
+            *logEntry = "Read value " + std::to_string(val) + " from " + address + " into " + program.slotNames[inst.dst];
+        break;
+    }
+    default:
+        break;
+    }
 
-                    ensurePageLoaded(*execScreen, addr);
-                    uint16_t val = 0;
-                    if (execScreen->memory.vars.count(valRef))
-                        val = execScreen->memory.vars[valRef];
-                    else
-                    {
-                        try
-                        {
-                            val = static_cast<uint16_t>(std::stoi(valRef));
-                        }
-                        catch (...)
-                        {
-                            logEntry = "WRITE failed: value not found.";
-                            break;
-                        }
-                    }
+    proc.instructionPointer++;
+    advancePastLoopControl(proc);
+    proc.currentLine++;
+    proc.cpuId = coreId;
+    proc.lastLogStamp = time(nullptr);
+    return true;
+}
 
-                    {
-                        std::lock_guard<std::mutex> lock(physicalMemoryMutex);
-                        physicalMemory[address] = val;
-                    }
+// One instruction of `proc` on `coreId`: executes it under the state lock, then logs and counts it.
+// Returns false when the process was shut down; sleepTicks is set by SLEEP.
+bool stepProcess(ExecutableScreen &proc, int coreId, int &sleepTicks)
+{
+    std::string logEntry;
+    {
+        std::lock_guard<CopyableMutex> stateLock(proc.stateMutex);
+        bool alive = executeInstruction(proc, coreId, logInstructions ? &logEntry : nullptr, sleepTicks);
+        publishProcessStatus(proc);
+        if (!alive)
+            return false;
+    }
 
-                    logEntry = "Wrote value " + std::to_string(val) + " to " + address;
-                    break;
-                }
-                case InstructionType::READ:
-                {
-                    std::string varName = inst.var1;
-                    std::string address = inst.var2;
+    if (logInstructions)
+        appendProcessLog(proc, proc.lastLogStamp, coreId, std::move(logEntry));
 
-                    int addr = 0;
-                    try
-                    {
-                        addr = std::stoi(address, nullptr, 16);
-                    }
-                    catch (...)
-                    {
-                        shutdownProcess(*execScreen, address);
-                        goto next_process;
-                    }
+    totalTicks++;
+    int tick = ++activeTicks;
+    int boostTicks = schedulerPolicy->boostTicks();
+    if (boostTicks > 0 && tick % boostTicks == 0)
+        boostReadyQueues(); // counted in instructions, so virtual runs boost on the same ticks every time
+    recordInstructionForSnapshot();
+    return true;
+}
 
-                    if (addr < 0 || addr >= MEM_TOTAL)
-                    {
-                        shutdownProcess(*execScreen, address);
-                        goto next_process;
-                    }
+// Exit path for finished and shut down processes
+void finishProcess(ExecutableScreen &proc, const std::string &policyName)
+{
+    std::lock_guard<CopyableMutex> stateLock(proc.stateMutex);
+    freeMemory(proc.name);
+    releaseProcessFrames(proc);
+    releaseBackingStore(proc);
+    closeProcessLog(proc);
+    time_t finished = time(nullptr);
+    proc.finishedTime = formatTimestamp(finished);
+    publishProcessStatus(proc, finished);
+    recordCompletion(proc, policyName);
+    proc.exited = true;
+    finishedInFull++;
+    processesFinished++;
+}
 
-                    ensurePageLoaded(*execScreen, addr);
-                    uint16_t val = 0;
-                    {
-                        std::lock_guard<std::mutex> lock(physicalMemoryMutex);
-                        val = physicalMemory.count(address) ? physicalMemory[address] : 0;
-                    }
+// Compacts the oldest finished processes beyond retain-finished into summaries, then drops compacted
+// shells from the front of `screens` (deque pop_front leaves the other processes where they are).
+// The caller holds screensMutex, which also keeps observers off the shells while they are freed.
+void retireFinishedScreens(std::deque<ExecutableScreen> &screens)
+{
+    for (auto it = screens.begin(); it != screens.end() && finishedInFull.load() > retainFinished; ++it)
+    {
+        if (it->compacted)
+            continue;
+        std::lock_guard<CopyableMutex> stateLock(it->stateMutex);
+        if (!it->exited)
+            continue; // a shut down process has its finishedTime before its core reaches finishProcess
+
+        ProcessSummary summary;
+        static_cast<Screen &>(summary) = static_cast<const Screen &>(*it);
+        summary.memorySize = it->memorySize;
+        summary.isShutdown = it->isShutdown;
+        summary.shutdownMessage = it->shutdownMessage;
+        finishedSummaries.push_back(std::move(summary));
+
+        it->program = EMPTY_PROGRAM;
+        std::vector<ExecutableScreen::PageTableEntry>().swap(it->pageTable);
+        std::vector<std::pair<int, int>>().swap(it->forStack);
+        it->memory = ProcessMemory{};
+        it->consoleOutput = ConsoleRing{};
+        it->log.reset();
+        releaseProcessStatus(*it);
+        it->compacted = true;
+        finishedInFull--;
+    }
 
-                    execScreen->memory.vars[varName] = val;
-                    logEntry = "Read value " + std::to_string(val) + " from " + address + " into " + varName;
-                    break;
-                }
-                default:
-                    break;
-                }
+    while (!screens.empty() && screens.front().compacted)
+        screens.pop_front();
+}
+
+void cpuWorker(int coreId)
+{
+    traceTid = coreId;
+    while (true)
+    {
+        ExecutableScreen *execScreen = takeReady(coreId);
+        if (!execScreen)
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            idleCores++;
+            cv.wait(lock, []
+                    { return readyCount.load() > 0 || (stopScheduler && sleepingCount.load() == 0); });
+            idleCores--;
+
+            if (stopScheduler && readyCount.load() == 0 && sleepingCount.load() == 0)
+                return;
 
-                execScreen->instructionPointer++;
-                execScreen->currentLine++;
-                execScreen->cpuId = coreId;
-                execScreen->lastLogTime = getCurrentDateTime();
+            continue;
+        }
+        activePerCore[coreId] = execScreen->status;
 
-                std::ofstream outFile(output_dir + "/" + execScreen->name + ".txt", std::ios::app);
-                if (outFile.is_open())
-                    outFile << "(" << execScreen->lastLogTime << ") Core:" << coreId << " " << logEntry << "\n";
+        double sliceStart = simulationNowMs();
+        if (!execScreen->hasRun)
+        {
+            execScreen->hasRun = true;
+            execScreen->firstRunMs = sliceStart;
+        }
 
-                std::this_thread::sleep_for(std::chrono::milliseconds(delayPerExec));
-                totalTicks++;
-                activeTicks++;
-                slice--;
+        // The core owns this process until the slice ends; the state lock only fences observers
+        SchedulerPolicy &policy = *schedulerPolicy;
+        int slice = policy.timeSlice(*execScreen);
+        long long runningKey = policy.key(*execScreen);
+        int executed = 0;
+        int parkedTicks = 0;
+        bool alive = true;
+        bool preempted = false;
+        while (executed != slice && execScreen->instructionPointer < (int)execScreen->program->code.size())
+        {
+            int sleepTicks = 0;
+            alive = stepProcess(*execScreen, coreId, sleepTicks);
+            if (!alive)
+                break;
 
-                static int snapshotCounter = 0;
-                snapshotCounter++;
-                if (snapshotCounter % quantum == 0)
-                {
-                    std::ofstream snap("memory_stamp_" + std::to_string(snapshotCounter) + ".txt");
-                    snap << "Timestamp: (" << getCurrentDateTime() << ")\n";
-
-                    int inMemCount = 0;
-                    for (const auto &b : memoryBlocks)
-                        if (!b.owner.empty())
-                            inMemCount++;
-                    snap << "Number of processes in memory: " << inMemCount << "\n";
-
-                    int externalFrag = 0;
-                    for (const auto &b : memoryBlocks)
-                        if (b.owner.empty())
-                            externalFrag += b.size;
-                    snap << "Total external fragmentation in KB: " << externalFrag / 1024 << "\n\n";
-
-                    snap << "----end---- = " << MEM_TOTAL << "\n";
-                    int cur = MEM_TOTAL;
-                    for (auto it = memoryBlocks.rbegin(); it != memoryBlocks.rend(); ++it)
-                    {
-                        if (!it->owner.empty())
-                        {
-                            snap << cur << "\n"
-                                 << it->owner << "\n"
-                                 << (cur - it->size) << "\n";
-                        }
-                        cur -= it->size;
-                    }
-                    snap << "----start---- = 0\n";
-                }
-            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(delayPerExec));
+            executed++;
 
-        next_process:
-            if (!execScreen->isShutdown &&
-                execScreen->instructionPointer < (int)execScreen->instructions.size())
+            // SLEEP hands the core back; with no exec delay a tick takes no time at all
+            if (sleepTicks > 0 && delayPerExec > 0)
             {
-                std::lock_guard<std::mutex> requeueLock(queueMutex);
-                readyQueue.push(execScreen);
-                cv.notify_one();
+                parkedTicks = sleepTicks;
+                break;
             }
-            else
+
+            if (policy.preemptive() && runQueues[coreId].headKey.load() < runningKey)
             {
-                freeMemory(execScreen->name);
-                execScreen->finishedTime = getCurrentDateTime();
+                preempted = true;
+                break; // a more urgent process is waiting on this core
             }
         }
+        double sliceEnd = simulationNowMs();
+        execScreen->cpuMs += sliceEnd - sliceStart;
+        activePerCore[coreId] = nullptr;
+        if (traceEnabled)
+        {
+            const char *end = !alive ? "shutdown"
+                              : execScreen->instructionPointer >= (int)execScreen->program->code.size() ? "exit"
+                              : parkedTicks > 0 ? "sleep"
+                              : preempted ? "preempt"
+                                          : "quantum-expired";
+            traceSlice(*execScreen, sliceStart, sliceEnd, executed, end);
+        }
 
-        else
+        if (alive && execScreen->instructionPointer < (int)execScreen->program->code.size())
         {
-            // FCFS: execute until done
-            while (execScreen->instructionPointer < (int)execScreen->instructions.size())
+            if (parkedTicks > 0)
             {
-                // You can insert similar switch-case here if you need FCFS mode
-                execScreen->instructionPointer++;
+                parkSleepingProcess(execScreen, parkedTicks);
+                continue;
             }
-            freeMemory(execScreen->name);
-            execScreen->finishedTime = getCurrentDateTime();
+            if (executed == slice)
+                policy.onSliceExpired(*execScreen);
+            // Back on this core's own queue, where idle cores can steal it
+            enqueueReady(execScreen, coreId);
+        }
+        else
+        {
+            finishProcess(*execScreen, policy.name());
         }
     }
 }
@@ -749,10 +2915,7 @@ void schedulerThreadFunc(std::deque<ExecutableScreen> &screens)
 {
     for (auto &screen : screens)
     {
-        std::unique_lock<std::mutex> lock(queueMutex);
-        readyQueue.push(&screen);
-        lock.unlock();
-        cv.notify_one();
+        enqueueReady(&screen);
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
 }
@@ -773,10 +2936,8 @@ void startPrintJob(std::deque<ExecutableScreen> &screens)
     // Wait for queue to empty instead of fixed sleep
     while (true)
     {
-        std::unique_lock<std::mutex> lock(queueMutex);
-        if (readyQueue.empty())
+        if (readyCount.load() == 0 && sleepingCount.load() == 0)
             break;
-        lock.unlock();
         std::this_thread::sleep_for(std::chrono::milliseconds(500));
     }
 
@@ -796,14 +2957,60 @@ void startPrintJob(std::deque<ExecutableScreen> &screens)
     // std::cout << "✅ Print job completed. Logs saved in: " << output_dir << "\n";
 }
 
-std::vector<Instruction> parseInstructionString(const std::string &raw, const std::string &procName)
+// Splits on ';' outside of [...], so a FOR body stays one piece
+std::vector<std::string> splitTopLevelInstructions(const std::string &raw)
+{
+    std::vector<std::string> parts;
+    std::string current;
+    int depth = 0;
+    for (char c : raw)
+    {
+        if (c == '[')
+            depth++;
+        else if (c == ']' && depth > 0)
+            depth--;
+        if (c == ';' && depth == 0)
+        {
+            parts.push_back(current);
+            current.clear();
+        }
+        else
+            current += c;
+    }
+    parts.push_back(current);
+    return parts;
+}
+
+// FOR([body], count) nests up to MAX_FOR_DEPTH levels; a deeper FOR is dropped with its body
+std::vector<Instruction> parseInstructionString(const std::string &raw, int depth = 0)
 {
     std::vector<Instruction> instructions;
-    std::istringstream iss(raw);
-    std::string inst;
 
-    while (std::getline(iss, inst, ';'))
+    for (const std::string &inst : splitTopLevelInstructions(raw))
     {
+        size_t start = inst.find_first_not_of(" \t\n\r\"");
+        if (start != std::string::npos && inst.compare(start, 3, "FOR") == 0)
+        {
+            size_t open = inst.find('[', start);
+            size_t close = inst.rfind(']');
+            if (open == std::string::npos || close == std::string::npos || close < open || depth >= MAX_FOR_DEPTH)
+                continue;
+
+            // The count after the body; a negative or out-of-range count drops the FOR like a bad literal would
+            size_t comma = inst.find(',', close);
+            std::string count = comma == std::string::npos ? std::string() : inst.substr(comma + 1);
+            count.erase(0, count.find_first_not_of(" \t\n\r"));
+            int repeatCount = 1;
+            if (isNumericOperand(count) && (!parseLiteralOperand(count, repeatCount) || repeatCount < 0))
+                continue;
+
+            Instruction ins{InstructionType::FOR};
+            ins.subInstructions = parseInstructionString(inst.substr(open + 1, close - open - 1), depth + 1);
+            ins.repeatCount = repeatCount;
+            instructions.push_back(ins);
+            continue;
+        }
+
         std::istringstream tokenStream(inst);
         std::string type;
         tokenStream >> type;
@@ -845,7 +3052,7 @@ std::vector<Instruction> parseInstructionString(const std::string &raw, const st
 
             if (fullLine.empty())
             {
-                ins.message = "Hello world from " + procName + "!";
+                ins.message = "Hello world from " + PROCESS_NAME_TOKEN + "!";
             }
             else
             {
@@ -905,6 +3112,9 @@ std::vector<Instruction> parseInstructionString(const std::string &raw, const st
     return instructions;
 }
 
+void initializeMemorySystem();
+void resetProgramPool();
+
 void readConfigFile(const std::string &filename)
 {
     std::ifstream file(filename);
@@ -928,12 +3138,18 @@ void readConfigFile(const std::string &filename)
         {
             file >> schedulerAlgo;
             std::cout << " - scheduler: " << schedulerAlgo << "\n";
+            schedulerPolicy = makeSchedulerPolicy(schedulerAlgo);
         }
         else if (param == "quantum-cycles")
         {
             file >> quantum;
             std::cout << " - quantum-cycles: " << quantum << "\n";
         }
+        else if (param == "mlfq-boost-ticks")
+        {
+            file >> mlfqBoostTicks;
+            std::cout << " - mlfq-boost-ticks: " << mlfqBoostTicks << "\n";
+        }
         else if (param == "batch-process-freq")
         {
             file >> batchFreq;
@@ -974,6 +3190,90 @@ void readConfigFile(const std::string &filename)
             file >> MAX_MEM_PER_PROC;
             std::cout << " - max-mem-per-proc: " << MAX_MEM_PER_PROC << "\n";
         }
+        else if (param == "mem-allocator")
+        {
+            file >> memAllocatorAlgo;
+            std::cout << " - mem-allocator: " << memAllocatorAlgo << "\n";
+        }
+        else if (param == "page-replacement")
+        {
+            file >> pageReplacementAlgo;
+            std::cout << " - page-replacement: " << pageReplacementAlgo << "\n";
+        }
+        else if (param == "log-instructions")
+        {
+            std::string value;
+            file >> value;
+            logInstructions = !(value == "false" || value == "off" || value == "0");
+            std::cout << " - log-instructions: " << (logInstructions ? "true" : "false") << "\n";
+        }
+        else if (param == "snapshot-interval")
+        {
+            file >> snapshotInterval;
+            std::cout << " - snapshot-interval: " << snapshotInterval << "\n";
+        }
+        else if (param == "snapshot-format")
+        {
+            file >> snapshotFormat;
+            if (snapshotFormat != "text" && snapshotFormat != "binary")
+            {
+                std::cout << "Unknown snapshot-format " << snapshotFormat << ", using text.\n";
+                snapshotFormat = "text";
+            }
+            std::cout << " - snapshot-format: " << snapshotFormat << "\n";
+        }
+        else if (param == "clock-mode")
+        {
+            file >> clockMode;
+            if (clockMode != "wall" && clockMode != "virtual")
+            {
+                std::cout << "Unknown clock-mode " << clockMode << ", using wall.\n";
+                clockMode = "wall";
+            }
+            std::cout << " - clock-mode: " << clockMode << "\n";
+        }
+        else if (param == "max-ticks")
+        {
+            file >> maxTicks;
+            std::cout << " - max-ticks: " << maxTicks << "\n";
+        }
+        else if (param == "random-seed")
+        {
+            unsigned seed;
+            file >> seed;
+            seedRandom(seed);
+            std::cout << " - random-seed: " << seed << "\n";
+        }
+        else if (param == "program-pool-size")
+        {
+            file >> programPoolSize;
+            std::cout << " - program-pool-size: " << programPoolSize << "\n";
+        }
+        else if (param == "console-buffer-lines")
+        {
+            file >> consoleBufferLines;
+            std::cout << " - console-buffer-lines: " << consoleBufferLines << "\n";
+        }
+        else if (param == "retain-finished")
+        {
+            file >> retainFinished;
+            std::cout << " - retain-finished: " << retainFinished << "\n";
+        }
+        else if (param == "page-trace-file")
+        {
+            file >> pageTraceFile;
+            std::cout << " - page-trace-file: " << pageTraceFile << "\n";
+        }
+        else if (param == "trace-file")
+        {
+            file >> traceFile;
+            std::cout << " - trace-file: " << traceFile << "\n";
+        }
+        else if (param == "trace-buffer-events")
+        {
+            file >> traceBufferEvents;
+            std::cout << " - trace-buffer-events: " << traceBufferEvents << "\n";
+        }
 
         else
         {
@@ -983,34 +3283,55 @@ void readConfigFile(const std::string &filename)
         }
     }
 
+    initializeMemorySystem();
+    resetProgramPool();
+    std::cout << " - total-frames: " << frameTable.size() << "\n";
+}
+
+// Rebuilds the allocator, physical memory, swap file and pager from the current config values
+void initializeMemorySystem()
+{
     // Reinitialize memory blocks
     {
         std::lock_guard<std::mutex> lock(memMutex);
-        memoryBlocks.clear();
-        memoryBlocks.push_back({0, MEM_TOTAL, ""});
+        memoryAllocator = makeMemoryAllocator(memAllocatorAlgo, MEM_TOTAL);
     }
 
     // Reset page/frame system
+    int totalFrames = MEM_TOTAL / MEM_FRAME_SIZE;
     {
-        std::lock_guard<std::mutex> lock(physicalMemoryMutex);
-        physicalMemory.clear();
+        std::lock_guard<std::mutex> lock(pagerMutex);
+        physicalMemory.assign(static_cast<size_t>(totalFrames) * MEM_FRAME_SIZE, 0);
     }
     frameTable.clear();
-    fifoFrameQueue = std::queue<int>();
+    resetBackingStore();
+
+    if (pageReplacementAlgo == "opt" && pageTraceFile.empty())
+        std::cout << "page-replacement opt needs a page-trace-file recorded by an earlier run.\n";
+    replacementPolicy = makeReplacementPolicy(pageReplacementAlgo);
+    if (pageTraceOut.is_open())
+        pageTraceOut.close();
+    if (!pageTraceFile.empty() && replacementPolicy->name() != "opt")
+        pageTraceOut.open(pageTraceFile, std::ios::binary | std::ios::trunc);
 
-    int totalFrames = MEM_TOTAL / MEM_FRAME_SIZE;
     frameTable = std::vector<FrameTableEntry>(totalFrames);
-    std::cout << " - total-frames: " << totalFrames << "\n";
+    resetFreeFrames();
 }
 
-std::vector<Instruction> generateRandomInstructions(int count, const std::string &processName = "")
+// READ/WRITE addresses are drawn from [0, memSize) so they stay inside the process's limit.
+// `count` is the number of executed lines: a FOR spends repeatCount * its body's lines of it.
+std::vector<Instruction> generateRandomInstructions(int count, int memSize = MIN_MEM_PER_PROC, int depth = 0)
 {
     std::vector<Instruction> instructions;
     std::vector<std::string> vars = {"x", "y", "z"};
 
-    for (int i = 0; i < count; ++i)
+    int remaining = count;
+    while (remaining > 0)
     {
-        int type = getRand(0, 6);
+        int type = getRand(0, 7);
+        if (type == 7 && (depth >= MAX_FOR_DEPTH || remaining < 2))
+            type = getRand(0, 6);
+        remaining--;
         switch (type)
         {
         case 0: // DECLARE
@@ -1025,7 +3346,7 @@ std::vector<Instruction> generateRandomInstructions(int count, const std::string
         {
             Instruction inst{InstructionType::PRINT};
             inst.var1 = vars[getRand(0, 2)];
-            inst.message = "Hello world from " + processName + "!";
+            inst.message = "Hello world from " + PROCESS_NAME_TOKEN + "!";
             instructions.push_back(inst);
             break;
         }
@@ -1058,7 +3379,7 @@ std::vector<Instruction> generateRandomInstructions(int count, const std::string
         {
 
             Instruction inst{InstructionType::WRITE};
-            inst.var1 = "0x" + std::to_string(0x1000 + getRand(0, 1024)); // random hex address
+            inst.var1 = toHexAddress(getRand(0, memSize - 1)); // random hex address
             inst.var2 = vars[getRand(0, 2)];
             instructions.push_back(inst);
             break;
@@ -1067,7 +3388,17 @@ std::vector<Instruction> generateRandomInstructions(int count, const std::string
         {
             Instruction inst{InstructionType::READ};
             inst.var1 = vars[getRand(0, 2)];
-            inst.var2 = "0x" + std::to_string(0x1000 + getRand(0, 1024)); // random hex address
+            inst.var2 = toHexAddress(getRand(0, memSize - 1)); // random hex address
+            instructions.push_back(inst);
+            break;
+        }
+        case 7: // FOR
+        {
+            Instruction inst{InstructionType::FOR};
+            inst.repeatCount = getRand(2, std::min(4, remaining + 1));
+            int bodyLines = getRand(1, std::max(1, std::min(4, (remaining + 1) / inst.repeatCount)));
+            inst.subInstructions = generateRandomInstructions(bodyLines, memSize, depth + 1);
+            remaining -= inst.repeatCount * bodyLines - 1;
             instructions.push_back(inst);
             break;
         }
@@ -1077,95 +3408,293 @@ std::vector<Instruction> generateRandomInstructions(int count, const std::string
     return instructions;
 }
 
+// Generated programs already compiled for each memory size (READ/WRITE addresses stay below it).
+// Once a size has programPoolSize of them, new processes share a random one instead of compiling.
+std::mutex programPoolMutex;
+std::map<int, std::vector<std::shared_ptr<const Program>>> programPool;
+
+std::shared_ptr<const Program> drawGeneratedProgram(int memSize)
+{
+    if (programPoolSize > 0)
+    {
+        std::lock_guard<std::mutex> lock(programPoolMutex);
+        const auto &pool = programPool[memSize];
+        if (static_cast<int>(pool.size()) >= programPoolSize)
+            return pool[getRand(0, static_cast<int>(pool.size()) - 1)];
+    }
+
+    auto program = std::make_shared<const Program>(compileProgram(
+        generateRandomInstructions(getRand(minInstructions, maxInstructions), memSize)));
+    if (programPoolSize > 0)
+    {
+        std::lock_guard<std::mutex> lock(programPoolMutex);
+        auto &pool = programPool[memSize];
+        if (static_cast<int>(pool.size()) < programPoolSize)
+            pool.push_back(program);
+    }
+    return program;
+}
+
+// Pooled programs were generated under the old min-ins/max-ins, so a new config drops them
+void resetProgramPool()
+{
+    std::lock_guard<std::mutex> lock(programPoolMutex);
+    programPool.clear();
+}
+
 bool isPowerOfTwo(int x)
 {
     return (x & (x - 1)) == 0;
 }
 
-int main()
+// Creates the next generator process pN and queues it; false when memory is full
+bool spawnGeneratedProcess(std::deque<ExecutableScreen> &screens, int &nextPid)
 {
-    bool isInitialized = false;
-    printHeader();
-    std::string cmd;
-    std::deque<ExecutableScreen> screens;
-    ExecutableScreen currentScreen;
-    ExecutableScreen mainMenu;
-    mainMenu.name = "Main Menu";
-    currentScreen = mainMenu;
-    std::string report_file_name = "csopesy-log.txt";
-    std::string report_util;
-    std::ostringstream report_stream;
+    ExecutableScreen exec{};
+    exec.pid = nextProcessId++;
+    exec.name = "p" + std::to_string(nextPid++);
+    exec.createdDate = getCurrentDateTime();
+    int memSize;
+    do
+    {
+        memSize = getRand(MIN_MEM_PER_PROC, MAX_MEM_PER_PROC);
+    } while (!isPowerOfTwo(memSize));
+    loadProgram(exec, drawGeneratedProgram(memSize));
+
+    if (!allocateProcessMemory(exec, memSize))
+    {
+        if (traceEnabled)
+            traceInstant("alloc-failed", exec.pid, "mem_size", memSize);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lg(screensMutex);
+    retireFinishedScreens(screens);
+    screens.push_back(std::move(exec));
+    registerProcessStatus(screens.back());
+    enqueueReady(&screens.back());
+    return true;
+}
+
+// Virtual clock: one loop iteration is one tick on every core. Arrivals, SLEEP wakeups and
+// quantum expiry all count ticks instead of sleeping, so with a fixed random-seed the
+// same config makes the same scheduling decisions, as fast as the host can run them.
+std::thread virtualSchedulerThread;
+std::mutex virtualSchedulerMutex;
+bool virtualSchedulerActive = false;
+
+void virtualSchedulerLoop(std::deque<ExecutableScreen> &screens)
+{
+    struct VirtualCore
+    {
+        ExecutableScreen *proc = nullptr;
+        int slice = 0;
+        int executed = 0;
+        long long key = 0;
+        double sliceStartMs = 0;
+    };
+
+    int cores = std::max(1, std::min(CPU_CORES, 128));
+    std::vector<VirtualCore> coreState(cores);
+    SchedulerPolicy &policy = *schedulerPolicy;
+    double tickMs = std::max(1, delayPerExec);
+    int nextPid = 1;
+    uint64_t stopTick = maxTicks > 0 ? virtualTick.load() + maxTicks : 0;
 
     while (true)
     {
-        std::cout << "Enter a command: ";
-        if (!std::getline(std::cin, cmd))
-            break;
+        traceTid = TRACE_TID_GENERATOR;
+        if (stopTick != 0 && virtualTick.load() >= stopTick)
+            schedulerRunning = false; // max-ticks: stop generating on a tick, not when the shell gets round to it
+        if (schedulerRunning && virtualTick.load() % std::max(1, batchFreq) == 0)
+            spawnGeneratedProcess(screens, nextPid);
 
-        std::istringstream inputStream(cmd);
-        std::vector<std::string> command;
-        std::string token;
-        while (inputStream >> token)
+        std::vector<ExecutableScreen *> due;
         {
-            command.push_back(token);
+            std::lock_guard<std::mutex> lock(sleepWheelMutex);
+            sleepWheel.advance(due);
         }
-
-        if (!isInitialized && !(command[0] == "initialize"))
+        for (ExecutableScreen *proc : due)
         {
-            std::cout << "Please run the 'initialize' command first.\n";
-            continue;
+            if (traceEnabled)
+                recordTraceEvent("SLEEP", 'e', traceNowUs(), 0, proc->pid, "ticks", 0);
+            enqueueReady(proc);
         }
-        if (command.empty())
+        sleepingCount -= static_cast<int>(due.size());
+
+        bool busy = false;
+        for (int c = 0; c < cores; ++c)
         {
-            continue;
+            VirtualCore &core = coreState[c];
+            traceTid = c;
+            if (!core.proc)
+            {
+                core.proc = takeReady(c);
+                if (!core.proc)
+                {
+                    idleTicks++;
+                    totalTicks++;
+                    continue;
+                }
+                activePerCore[c] = core.proc->status;
+                core.slice = policy.timeSlice(*core.proc);
+                core.key = policy.key(*core.proc);
+                core.executed = 0;
+                core.sliceStartMs = simulationNowMs();
+                if (!core.proc->hasRun)
+                {
+                    core.proc->hasRun = true;
+                    core.proc->firstRunMs = simulationNowMs();
+                }
+            }
+
+            busy = true;
+            ExecutableScreen &proc = *core.proc;
+            int sleepTicks = 0;
+            bool alive = stepProcess(proc, c, sleepTicks);
+            core.executed++;
+            proc.cpuMs += tickMs;
+
+            const char *end;
+            bool exiting = !alive || proc.instructionPointer >= (int)proc.program->code.size();
+            if (exiting)
+            {
+                end = alive ? "exit" : "shutdown";
+            }
+            else if (sleepTicks > 0)
+            {
+                parkSleepingProcess(&proc, sleepTicks);
+                end = "sleep";
+            }
+            else if (core.executed == core.slice)
+            {
+                policy.onSliceExpired(proc);
+                enqueueReady(&proc, c);
+                end = "quantum-expired";
+            }
+            else if (policy.preemptive() && runQueues[c].headKey.load() < core.key)
+            {
+                enqueueReady(&proc, c);
+                end = "preempt";
+            }
+            else
+            {
+                continue; // keeps the core next tick
+            }
+            if (traceEnabled)
+                traceSlice(proc, core.sliceStartMs, simulationNowMs() + tickMs, core.executed, end); // the slice ends after this tick
+            activePerCore[c] = nullptr;
+            core.proc = nullptr;
+            if (exiting)
+                finishProcess(proc, policy.name()); // last touch: the shell may compact it from here on
         }
-        else if (command[0] == "scheduler-start" && currentScreen.name == "Main Menu")
+        virtualTick++;
+
+        if (!schedulerRunning && !busy && readyCount.load() == 0 && sleepingCount.load() == 0)
         {
+            // Rechecked under the lock so a scheduler-start racing with the exit is not lost
+            std::lock_guard<std::mutex> lock(virtualSchedulerMutex);
             if (!schedulerRunning)
             {
-                schedulerRunning = true;
+                virtualSchedulerActive = false;
+                return;
+            }
+        }
+    }
+}
+
+// Starts the virtual scheduler unless it is already running
+void startVirtualScheduler(std::deque<ExecutableScreen> &screens)
+{
+    std::lock_guard<std::mutex> lock(virtualSchedulerMutex);
+    if (virtualSchedulerActive)
+        return;
+    if (virtualSchedulerThread.joinable())
+        virtualSchedulerThread.join(); // previous run already returned
+    virtualSchedulerActive = true;
+    virtualSchedulerThread = std::thread(virtualSchedulerLoop, std::ref(screens));
+}
+
+// Waits for the virtual scheduler to drain; call after clearing schedulerRunning
+void joinVirtualScheduler()
+{
+    if (virtualSchedulerThread.joinable())
+        virtualSchedulerThread.join();
+}
+
+// True while processes are still being generated or the virtual scheduler is draining
+bool schedulerBusy()
+{
+    std::lock_guard<std::mutex> lock(virtualSchedulerMutex);
+    return schedulerRunning || virtualSchedulerActive;
+}
+
+#ifndef CSOPESY_NO_MAIN // benchmark.cpp includes this file and brings its own main
+// REPL state that outlives a single command
+struct ShellState
+{
+    bool isInitialized = false;
+    std::deque<ExecutableScreen> screens;
+    ExecutableScreen currentScreen;
+    ExecutableScreen mainMenu;
+    std::string report_file_name = "csopesy-log.txt";
+    std::string report_util;
+    std::ostringstream report_stream;
+};
+
+// Runs one shell command, for the interactive prompt and for --batch scripts alike.
+// Returns false once `exit` at the main menu has shut the simulator down.
+bool handleCommand(ShellState &shell, const std::string &cmd)
+{
+    bool &isInitialized = shell.isInitialized;
+    std::deque<ExecutableScreen> &screens = shell.screens;
+    ExecutableScreen &currentScreen = shell.currentScreen;
+    const ExecutableScreen &mainMenu = shell.mainMenu;
+    std::string &report_file_name = shell.report_file_name;
+    std::string &report_util = shell.report_util;
+    std::ostringstream &report_stream = shell.report_stream;
+
+    std::istringstream inputStream(cmd);
+    std::vector<std::string> command;
+    std::string token;
+    while (inputStream >> token)
+    {
+        command.push_back(token);
+    }
+
+    if (command.empty())
+    {
+        return true;
+    }
+    if (!isInitialized && !(command[0] == "initialize"))
+    {
+        std::cout << "Please run the 'initialize' command first.\n";
+        return true;
+    }
+    else if (command[0] == "scheduler-start" && currentScreen.name == "Main Menu")
+    {
+        if (!schedulerRunning)
+        {
+            schedulerRunning = true;
 
+            if (clockMode == "virtual")
+            {
+                startVirtualScheduler(screens);
+            }
+            else
+            {
                 schedulerGeneratorThread = std::thread([&screens]()
                                                        {
+                    traceTid = TRACE_TID_GENERATOR;
                     int nextPid = 1;
                     while (schedulerRunning)
                     {
-                        ExecutableScreen exec{};
-                        exec.name = "p" + std::to_string(nextPid++);
-                        exec.instructions = generateRandomInstructions(getRand(minInstructions, maxInstructions), exec.name);
-                        exec.totalLines    = exec.instructions.size();
-                        exec.createdDate = getCurrentDateTime();
-                        int memSize;
-                        do {
-                            memSize = getRand(MIN_MEM_PER_PROC, MAX_MEM_PER_PROC);
-                        } while (!isPowerOfTwo(memSize));
-
-                        int allocStart = allocateMemory(exec.name, memSize);
-                        exec.memorySize = memSize;
-
-                        if (allocStart == -1)
-                        {
-                            // std::cout << "[generator] Skipped " << exec.name << ": insufficient memory.\n";
-                            std::this_thread::sleep_for(std::chrono::milliseconds(batchFreq * delayPerExec));
-                            continue;
-                        }
-
-                        {
-                            std::lock_guard<std::mutex> lg(screensMutex);
-                            screens.push_back(std::move(exec));
-                            ExecutableScreen *p = &screens.back();
-
-                            {
-                                std::lock_guard<std::mutex> ql(queueMutex);
-                                readyQueue.push(p);
-                            }
-                            cv.notify_one();                        
-                        }
-
-                        std::this_thread::sleep_for(std::chrono::milliseconds(batchFreq * delayPerExec));
+                        spawnGeneratedProcess(screens, nextPid); // skipped when memory is full
+                        std::unique_lock<std::mutex> lock(generatorMutex);
+                        generatorCv.wait_for(lock, std::chrono::milliseconds(batchFreq * delayPerExec), []
+                                             { return !schedulerRunning; });
                     } });
 
-                schedulerGeneratorThread.detach();
                 if (!isPrinting)
                 {
                     isPrinting = true;
@@ -1176,516 +3705,768 @@ int main()
                         cpuThreads.emplace_back(cpuWorker, i);
                     }
                 }
+            }
+
+            std::cout << "Scheduler started.\n";
+        }
+        else
+        {
+            std::cout << "Scheduler is already running.\n";
+        }
+    }
+    else if (command[0] == "scheduler-stop" && currentScreen.name == "Main Menu")
+    {
+        if (schedulerRunning)
+        {
+            // Stop generating
+            stopGenerator();
+            joinVirtualScheduler();
+
+            // Tell CPU workers to quit once the queue is empty
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                stopScheduler = true;
+            }
+            cv.notify_all();
+
+            // Join all worker threads
+            for (auto &t : cpuThreads)
+                t.join();
+            cpuThreads.clear();
+            isPrinting = false;
+            flushProcessLogs();
+            writeTraceFile();
+        }
+        else
+        {
+            std::cout << "Scheduler is not running.\n";
+        }
+    }
+    else if (command[0] == "exit")
+    {
+        if (currentScreen.name != "Main Menu")
+        {
+            currentScreen = mainMenu;
+            clearScreen();
+            printHeader();
+            return true;
+        }
+        else
+        {
+            // Gracefully shutdown all threads
+            stopGenerator();
+            stopScheduler = true;
+            cv.notify_all();
+            joinVirtualScheduler();
+
+            for (auto &t : cpuThreads)
+            {
+                if (t.joinable())
+                    t.join();
+            }
+
+            cpuThreads.clear();
+            stopSleepTicker();
+            stopSnapshotWriter();
+            stopLogFlusher();
+            writeTraceFile();
+
+            return false;
+        }
+    }
+    else if (command[0] == "process-smi")
+    {
+        if (currentScreen.name == "Main Menu")
+        {
+            std::cout << "\n===== PROCESS SMI =====\n";
+
+            // Memory overview
+            int usedMem = 0;
+            int freeMem = 0;
+            {
+                std::lock_guard<std::mutex> lock(memMutex);
+                usedMem = memoryAllocator->usedBytes;
+                freeMem = MEM_TOTAL - usedMem;
+            }
+
+            std::cout << "Memory Used    : " << usedMem << " bytes\n";
+            std::cout << "Memory Free    : " << freeMem << " bytes\n";
+            std::cout << "Total Memory   : " << MEM_TOTAL << " bytes\n\n";
+
+            // Header
+            std::cout << std::left
+                      << std::setw(14) << "Process"
+                      << std::setw(10) << "MemUsed"
+                      << std::setw(10) << "CPU"
+                      << std::setw(12) << "Status"
+                      << "Last Log\n";
+            std::cout << std::string(60, '-') << "\n";
+
+            for (const auto &row : snapshotProcessStatus())
+            {
+                std::cout << std::left
+                          << std::setw(14) << row.name
+                          << std::setw(10) << row.memorySize
+                          << std::setw(10) << row.cpuId
+                          << std::setw(12) << processStatusLabel(row)
+                          << formatLastLog(row) << "\n";
+            }
+
+            std::cout << std::string(60, '=') << "\n\n";
+        }
+        else
+        {
+            std::cout << "\n===== PROCESS SMI =====\n";
+            std::cout << std::left
+                      << std::setw(12) << "Process"
+                      << std::setw(10) << "MemUsed"
+                      << std::setw(10) << "CPU"
+                      << std::setw(12) << "Status"
+                      << "Last Log\n";
+            std::cout << std::string(60, '-') << "\n";
+
+            for (const auto &row : snapshotProcessStatus())
+            {
+                std::cout << std::left
+                          << std::setw(12) << row.name
+                          << std::setw(10) << row.memorySize
+                          << std::setw(10) << row.cpuId
+                          << std::setw(12) << processStatusLabel(row)
+                          << formatLastLog(row) << "\n";
+            }
+
+            std::cout << std::string(60, '=') << "\n";
+        }
+    }
+    else if (command[0] == "vmstat")
+    {
+        // Figures are copied under their locks and printed afterwards, so a slow console never
+        // holds up a process exit (memMutex) or a completion record (schedulingStatsMutex)
+        int usedMem = 0;
+        int freeBlocks = 0;
+        int largestFree = 0;
+        long long allocations = 0;
+        long long failedAllocations = 0;
+        int requestedBytes = 0;
+        std::string allocatorName;
+        {
+            std::lock_guard<std::mutex> lock(memMutex);
+            usedMem = memoryAllocator->usedBytes;
+            allocations = memoryAllocator->allocations;
+            failedAllocations = memoryAllocator->failedAllocations;
+            requestedBytes = memoryAllocator->requestedBytes;
+            allocatorName = memoryAllocator->name();
+            for (const auto &block : memoryAllocator->blocks())
+            {
+                if (block.owner.empty())
+                {
+                    freeBlocks++;
+                    largestFree = std::max(largestFree, block.size);
+                }
+            }
+        }
+        int freeMem = MEM_TOTAL - usedMem;
+
+        std::cout << "\n------ VMSTAT REPORT ------\n";
+        std::cout << "Total memory       : " << MEM_TOTAL << " bytes\n";
+        std::cout << "Used memory        : " << usedMem << " bytes\n";
+        std::cout << "Free memory        : " << freeMem << " bytes\n";
+        std::cout << "Memory allocator   : " << allocatorName << "\n";
+        std::cout << "Allocations        : " << allocations
+                  << " (" << failedAllocations << " failed)\n";
+        std::cout << "Free blocks        : " << freeBlocks << " (largest " << largestFree << " bytes)\n";
+        std::cout << "Internal frag      : " << usedMem - requestedBytes << " bytes\n";
+        std::cout << "Active CPU ticks   : " << activeTicks.load() << "\n";
+        std::cout << "Idle CPU ticks     : " << idleTicks.load() << "\n";
+        std::cout << "Total CPU ticks    : " << totalTicks.load() << "\n";
+        std::cout << "Pages Paged In     : " << pagesPagedIn.load() << "\n";
+        std::cout << "Pages Paged Out    : " << pagesPagedOut.load() << "\n";
+        std::cout << "  Dirty write-backs: " << pagesWrittenBack.load() << "\n";
+        std::cout << "  Clean drops      : " << pagesDroppedClean.load() << "\n";
+        std::cout << "Snapshots dropped  : " << snapshotsDropped.load() << "\n";
+
+        auto faultRate = [](long long faults, long long accesses)
+        {
+            return accesses == 0 ? 0.0 : 100.0 * faults / accesses;
+        };
+        std::string policyName = replacementPolicy ? replacementPolicy->name() : pageReplacementAlgo;
+        std::map<std::string, PagingStats> byPolicy = pagingStatsByPolicy;
+        byPolicy[policyName].accesses += pageAccesses.load();
+        byPolicy[policyName].faults += pagesPagedIn.load();
+
+        std::cout << "Page replacement   : " << policyName << "\n";
+        std::cout << "Page accesses      : " << pageAccesses.load() << "\n";
+        std::cout << "Fault rate         : " << std::fixed << std::setprecision(2)
+                  << faultRate(pagesPagedIn.load(), pageAccesses.load()) << "%\n";
+        std::cout << "Fault rate by policy:\n";
+        for (const auto &kv : byPolicy)
+        {
+            std::cout << "  " << std::left << std::setw(17) << kv.first << ": "
+                      << faultRate(kv.second.faults, kv.second.accesses) << "% ("
+                      << kv.second.faults << " / " << kv.second.accesses << ")\n";
+        }
+        std::cout << "Scheduler          : " << schedulerPolicy->name() << "\n";
+        std::cout << "Scheduling by policy (avg ms):\n";
+        std::map<std::string, SchedulingStats> schedulingByPolicy;
+        {
+            std::lock_guard<std::mutex> statsLock(schedulingStatsMutex);
+            schedulingByPolicy = schedulingStatsByPolicy;
+        }
+        for (const auto &kv : schedulingByPolicy)
+        {
+            const SchedulingStats &st = kv.second;
+            std::cout << "  " << std::left << std::setw(17) << kv.first << ": "
+                      << st.completed << " done, turnaround " << st.turnaroundMs / st.completed
+                      << ", waiting " << st.waitingMs / st.completed
+                      << ", response " << st.responseMs / st.completed << "\n";
+        }
+        std::cout << std::defaultfloat;
+        std::cout << "----------------------------\n\n";
+    }
+    else if (command[0] == "backing-store-dump")
+    {
+        int dumped = dumpBackingStore(BACKING_STORE_DUMP_FILE);
+        std::cout << "Dumped " << dumped << " swapped-out pages to " << BACKING_STORE_DUMP_FILE << "\n";
+    }
+    else if (command[0] == "clear" && currentScreen.name == "Main Menu")
+    {
+        clearScreen();
+        printHeader();
+    }
+    else if (command[0] == "screen" && currentScreen.name == "Main Menu")
+    {
+        if (command[1] == "-s" && command.size() == 4)
+        {
+            std::string procName = command[2];
+            int memSize = std::stoi(command[3]);
 
-                std::cout << "Scheduler started.\n";
-            }
-            else
+            if (memSize < 64 || memSize > 8192 || (memSize & (memSize - 1)) != 0)
             {
-                std::cout << "Scheduler is already running.\n";
+                std::cout << "Invalid memory allocation.\n";
+                return true;
             }
-        }
-        else if (command[0] == "scheduler-stop" && currentScreen.name == "Main Menu")
-        {
-            if (schedulerRunning)
-            {
-                // Stop generating
-                schedulerRunning = false;
-                if (schedulerGeneratorThread.joinable())
-                    schedulerGeneratorThread.join();
 
-                // Tell CPU workers to quit once the queue is empty
-                {
-                    std::lock_guard<std::mutex> lock(queueMutex);
-                    stopScheduler = true;
-                }
-                cv.notify_all();
+            ExecutableScreen proc = createScreen(procName);
+            loadProgram(proc, drawGeneratedProgram(memSize));
 
-                // Join all worker threads
-                for (auto &t : cpuThreads)
-                    t.join();
-                cpuThreads.clear();
-                isPrinting = false;
-            }
-            else
+            if (!allocateProcessMemory(proc, memSize))
             {
-                std::cout << "Scheduler is not running.\n";
+                std::cout << "Memory allocation failed.\n";
+                return true;
             }
-        }
-        else if (command[0] == "exit")
-        {
-            if (currentScreen.name != "Main Menu")
+
             {
-                currentScreen = mainMenu;
-                clearScreen();
-                printHeader();
-                continue;
+                std::lock_guard<std::mutex> lg(screensMutex);
+                retireFinishedScreens(screens);
+                screens.push_back(std::move(proc));
+                registerProcessStatus(screens.back());
+                ExecutableScreen *p = &screens.back();
+                enqueueReady(p);
+                currentScreen = snapshotScreen(*p);
             }
-            else
-            {
-                // Gracefully shutdown all threads
-                schedulerRunning = false;
-                stopScheduler = true;
-                cv.notify_all();
-
-                if (schedulerGeneratorThread.joinable())
-                    schedulerGeneratorThread.join();
-
-                for (auto &t : cpuThreads)
-                {
-                    if (t.joinable())
-                        t.join();
-                }
-
-                cpuThreads.clear();
 
-                break;
-            }
+            clearScreen();
+            printScreen(currentScreen);
         }
-        else if (command[0] == "process-smi")
+        else if (command[1] == "-r" && command.size() == 3)
         {
-            if (currentScreen.name == "Main Menu")
+            bool found = false;
+            std::lock_guard<std::mutex> lock(screensMutex);
+            for (auto &s : screens)
             {
-                std::cout << "\n===== PROCESS SMI =====\n";
-
-                // Memory overview
-                int usedMem = 0;
-                int freeMem = 0;
+                if (!s.compacted && s.name == command[2])
                 {
-                    std::lock_guard<std::mutex> lock(memMutex);
-                    for (const auto &block : memoryBlocks)
-                    {
-                        if (block.owner.empty())
-                            freeMem += block.size;
-                        else
-                            usedMem += block.size;
-                    }
-                }
-
-                std::cout << "Memory Used    : " << usedMem << " bytes\n";
-                std::cout << "Memory Free    : " << freeMem << " bytes\n";
-                std::cout << "Total Memory   : " << MEM_TOTAL << " bytes\n\n";
+                    currentScreen = snapshotScreen(s);
+                    clearScreen();
 
-                // Header
-                std::cout << std::left
-                          << std::setw(14) << "Process"
-                          << std::setw(10) << "MemUsed"
-                          << std::setw(10) << "CPU"
-                          << std::setw(12) << "Status"
-                          << "Last Log\n";
-                std::cout << std::string(60, '-') << "\n";
-
-                std::lock_guard<std::mutex> lock(screensMutex);
-                for (const auto &proc : screens)
-                {
-                    std::string status;
-                    if (proc.isShutdown)
+                    if (currentScreen.isShutdown)
                     {
-                        status = "Shutdown";
-                    }
-                    else if (proc.currentLine >= proc.totalLines)
-                    {
-                        status = "Finished";
+                        std::cout << currentScreen.shutdownMessage << "\n";
                     }
                     else
                     {
-                        status = "Running";
+                        printScreen(currentScreen);
                     }
-
-                    std::cout << std::left
-                              << std::setw(14) << proc.name
-                              << std::setw(10) << proc.memorySize
-                              << std::setw(10) << proc.cpuId
-                              << std::setw(12) << status
-                              << proc.lastLogTime << "\n";
+                    found = true;
+                    break;
                 }
-
-                std::cout << std::string(60, '=') << "\n\n";
             }
-            else
+            for (auto it = finishedSummaries.rbegin(); !found && it != finishedSummaries.rend(); ++it)
             {
-                std::lock_guard<std::mutex> lock(screensMutex);
-                std::cout << "\n===== PROCESS SMI =====\n";
-                std::cout << std::left
-                          << std::setw(12) << "Process"
-                          << std::setw(10) << "MemUsed"
-                          << std::setw(10) << "CPU"
-                          << std::setw(12) << "Status"
-                          << "Last Log\n";
-                std::cout << std::string(60, '-') << "\n";
-
-                for (const auto &proc : screens)
+                if (it->name == command[2])
                 {
-                    std::string status = "Running";
-                    if (proc.isShutdown)
-                    {
-                        status = "Shutdown";
-                    }
-                    else if (proc.currentLine >= proc.totalLines)
-                    {
-                        status = "Finished";
-                    }
-
-                    std::cout << std::left
-                              << std::setw(12) << proc.name
-                              << std::setw(10) << proc.memorySize
-                              << std::setw(10) << proc.cpuId
-                              << std::setw(12) << status
-                              << proc.lastLogTime << "\n";
+                    clearScreen();
+                    if (it->isShutdown)
+                        std::cout << it->shutdownMessage << "\n";
+                    else
+                        printSummary(*it);
+                    found = true;
                 }
-
-                std::cout << std::string(60, '=') << "\n";
             }
-        }
-        else if (command[0] == "vmstat")
-        {
-            std::lock_guard<std::mutex> lock(memMutex);
-            int usedMem = 0;
-            int freeMem = 0;
-            for (const auto &block : memoryBlocks)
+            if (!found)
             {
-                if (block.owner.empty())
-                    freeMem += block.size;
-                else
-                    usedMem += block.size;
+                std::cout << "Process " + command[2] + " not found.\n";
             }
-
-            std::cout << "\n------ VMSTAT REPORT ------\n";
-            std::cout << "Total memory       : " << MEM_TOTAL << " bytes\n";
-            std::cout << "Used memory        : " << usedMem << " bytes\n";
-            std::cout << "Free memory        : " << freeMem << " bytes\n";
-            std::cout << "Active CPU ticks   : " << activeTicks.load() << "\n";
-            std::cout << "Idle CPU ticks     : " << idleTicks.load() << "\n";
-            std::cout << "Total CPU ticks    : " << totalTicks.load() << "\n";
-            std::cout << "Pages Paged In     : " << pagesPagedIn.load() << "\n";
-            std::cout << "Pages Paged Out    : " << pagesPagedOut.load() << "\n";
-            std::cout << "----------------------------\n\n";
-        }
-        else if (command[0] == "clear" && currentScreen.name == "Main Menu")
-        {
-            clearScreen();
-            printHeader();
         }
-        else if (command[0] == "screen" && currentScreen.name == "Main Menu")
+        else if (command[1] == "-ls" && command.size() == 2)
         {
-            if (command[1] == "-s" && command.size() == 4)
+            // Count active/running processes
+            std::unordered_set<int> usedCores;
+            std::vector<ProcessStatusView> rows = snapshotProcessStatus();
+            for (const auto &s : rows)
             {
-                std::string procName = command[2];
-                int memSize = std::stoi(command[3]);
-
-                if (memSize < 64 || memSize > 8192 || (memSize & (memSize - 1)) != 0)
+                if (s.currentLine > 0 && s.currentLine < s.totalLines)
                 {
-                    std::cout << "Invalid memory allocation.\n";
-                    continue;
+                    usedCores.insert(s.cpuId); // actual running cores
                 }
+            }
+            int activeCores = static_cast<int>(usedCores.size());
+            int totalCores = CPU_CORES;
+            int availableCores = totalCores - activeCores;
+            float utilization = (static_cast<float>(activeCores) / totalCores) * 100.0f;
+
+            // Clamp utilization to 100%
+            if (utilization > 100.0f)
+                utilization = 100.0f;
+
+            // Write CPU stats
+            report_stream << "CPU Utilization: " << std::fixed << std::setprecision(2) << utilization << "%\n";
+            report_stream << "Cores Used: " << activeCores << "\n";
+            report_stream << "Cores Available: " << availableCores << "\n\n";
+
+            // Generate Report
+            report_stream << "------------------------------\nRunning processes:\n";
+            for (const auto &[core, proc] : snapshotRunningStatus())
+            {
+                report_stream << proc.name << "  "
+                              << formatLastLog(proc) << "    "
+                              << "Core " << core << "    "
+                              << proc.currentLine << " / "
+                              << proc.totalLines << "\n";
+            }
 
-                ExecutableScreen proc = createScreen(procName);
-                proc.memorySize = memSize;
-                proc.instructions = generateRandomInstructions(
-                    getRand(minInstructions, maxInstructions), procName);
-                proc.totalLines = static_cast<int>(proc.instructions.size());
-
-                int allocStart = allocateMemory(procName, memSize);
-                if (allocStart == -1)
+            report_stream << "\nFinished processes:\n";
+            for (size_t i = 0; i < rows.size(); ++i)
+            {
+                if (rows[i].currentLine == rows[i].totalLines)
                 {
-                    std::cout << "Memory allocation failed.\n";
-                    continue;
+                    report_stream << "process" << i << "  "
+                                  << (rows[i].finishedTime.empty() ? "Getting finishing time..." : rows[i].finishedTime) << "    "
+                                  << "Finished    "
+                                  << rows[i].currentLine << " / "
+                                  << rows[i].totalLines << "\n";
                 }
+            }
+            report_stream << "------------------------------\n";
 
-                {
-                    std::lock_guard<std::mutex> lg(screensMutex);
-                    screens.push_back(std::move(proc));
-                    ExecutableScreen *p = &screens.back();
-                    {
-                        std::lock_guard<std::mutex> ql(queueMutex);
-                        readyQueue.push(p);
-                    }
-                    cv.notify_one();
-                }
+            // Save report to local
+            report_util = report_stream.str();
+
+            // Print report
+            std::cout << report_util;
+
+            report_stream.str("");
+            report_stream.clear(); // properly clear the stream
+        }
+        else if (command[1] == "-c" && command.size() >= 4)
+        {
+            std::string procName = command[2];
+            int memSize = std::stoi(command[3]);
 
-                currentScreen = screens.back();
-                clearScreen();
-                printScreen(currentScreen);
+            // Memory validation
+            if (memSize < 64 || memSize > 8192 || (memSize & (memSize - 1)) != 0)
+            {
+                std::cout << "Invalid memory allocation.\n";
+                return true;
             }
-            else if (command[1] == "-r" && command.size() == 3)
+
+            // Reconstruct instruction string (everything after the 4th token)
+            size_t firstQuote = cmd.find("\"");
+            size_t lastQuote = cmd.rfind("\"");
+            std::string rawInstructions;
+            if (firstQuote != std::string::npos && lastQuote != std::string::npos && lastQuote > firstQuote)
             {
-                bool found = false;
-                for (auto &s : screens)
-                {
-                    if (s.name == command[2])
-                    {
-                        currentScreen = s;
-                        clearScreen();
-
-                        if (s.isShutdown)
-                        {
-                            std::cout << s.shutdownMessage << "\n";
-                        }
-                        else
-                        {
-                            printScreen(s);
-                        }
-                        found = true;
-                        break;
-                    }
-                }
-                if (!found)
-                {
-                    std::cout << "Process " + command[2] + " not found.\n";
-                }
+                rawInstructions = cmd.substr(firstQuote + 1, lastQuote - firstQuote - 1);
             }
-            else if (command[1] == "-ls" && command.size() == 2)
+            else
             {
-                // Count active/running processes
-                std::unordered_set<int> usedCores;
-                for (const auto &s : screens)
-                {
-                    if (s.currentLine > 0 && s.currentLine < s.totalLines)
-                    {
-                        usedCores.insert(s.cpuId); // actual running cores
-                    }
-                }
-                int activeCores = static_cast<int>(usedCores.size());
-                int totalCores = CPU_CORES;
-                int availableCores = totalCores - activeCores;
-                float utilization = (static_cast<float>(activeCores) / totalCores) * 100.0f;
-
-                // Clamp utilization to 100%
-                if (utilization > 100.0f)
-                    utilization = 100.0f;
-
-                // Write CPU stats
-                report_stream << "CPU Utilization: " << std::fixed << std::setprecision(2) << utilization << "%\n";
-                report_stream << "Cores Used: " << activeCores << "\n";
-                report_stream << "Cores Available: " << availableCores << "\n\n";
-
-                // Generate Report
-                report_stream << "------------------------------\nRunning processes:\n";
-                for (int i = 0; i < CPU_CORES; ++i)
-                {
-                    ExecutableScreen *proc = activePerCore[i];
-                    if (proc != nullptr)
-                    {
-                        report_stream << proc->name << "  "
-                                      << proc->lastLogTime << "    "
-                                      << "Core " << i << "    "
-                                      << proc->currentLine << " / "
-                                      << proc->totalLines << "\n";
-                    }
-                }
+                std::cout << "Invalid instruction format.\n";
+                return true;
+            }
 
-                report_stream << "\nFinished processes:\n";
-                for (size_t i = 0; i < screens.size(); ++i)
-                {
-                    if (screens[i].currentLine == screens[i].totalLines)
-                    {
-                        report_stream << "process" << i << "  "
-                                      << (screens[i].finishedTime.empty() ? "Getting finishing time..." : screens[i].finishedTime) << "    "
-                                      << "Finished    "
-                                      << screens[i].currentLine << " / "
-                                      << screens[i].totalLines << "\n";
-                    }
-                }
-                report_stream << "------------------------------\n";
+            ExecutableScreen proc = createScreen(procName);
+            std::vector<Instruction> instructions = parseInstructionString(rawInstructions);
 
-                // Save report to local
-                report_util = report_stream.str();
+            if (instructions.size() < 1 || instructions.size() > 50)
+            {
+                std::cout << "Number of instructions should be between 1-50\n";
+                return true;
+            }
 
-                // Print report
-                std::cout << report_util;
+            loadProgram(proc, std::make_shared<const Program>(compileProgram(instructions)));
 
-                report_stream.str("");
-                report_stream.clear(); // properly clear the stream
-            }
-            else if (command[1] == "-c" && command.size() >= 4)
+            if (!allocateProcessMemory(proc, memSize))
             {
-                std::string procName = command[2];
-                int memSize = std::stoi(command[3]);
+                std::cout << "Memory allocation failed.\n";
+                return true;
+            }
 
-                // Memory validation
-                if (memSize < 64 || memSize > 8192 || (memSize & (memSize - 1)) != 0)
-                {
-                    std::cout << "Invalid memory allocation.\n";
-                    return 0;
-                }
+            {
+                std::lock_guard<std::mutex> lg(screensMutex);
+                retireFinishedScreens(screens);
+                screens.push_back(std::move(proc));
+                registerProcessStatus(screens.back());
+                ExecutableScreen *p = &screens.back();
+                enqueueReady(p);
+                currentScreen = snapshotScreen(*p);
+            }
 
-                // Reconstruct instruction string (everything after the 4th token)
-                size_t firstQuote = cmd.find("\"");
-                size_t lastQuote = cmd.rfind("\"");
-                std::string rawInstructions;
-                if (firstQuote != std::string::npos && lastQuote != std::string::npos && lastQuote > firstQuote)
-                {
-                    rawInstructions = cmd.substr(firstQuote + 1, lastQuote - firstQuote - 1);
-                }
-                else
+            if (clockMode == "virtual")
+            {
+                startVirtualScheduler(screens);
+            }
+            else if (!isPrinting)
+            {
+                isPrinting = true;
+                stopScheduler = false;
+                for (int i = 0; i < CPU_CORES; ++i)
                 {
-                    std::cout << "Invalid instruction format.\n";
-                    continue;
+                    cpuThreads.emplace_back(cpuWorker, i);
                 }
+            }
 
-                ExecutableScreen proc = createScreen(procName);
-                proc.instructions = parseInstructionString(rawInstructions, procName);
+            clearScreen();
+            printScreen(currentScreen);
+        }
+    }
+    else if (command[0] == "generate" && command.size() == 2)
+    {
+        int n = std::stoi(command[1]);
+        for (int i = 0; i < n; ++i)
+        {
+            std::string pname = "p" + std::to_string(i + 1);
+            ExecutableScreen proc = createScreen(pname);
+            loadProgram(proc, drawGeneratedProgram(MIN_MEM_PER_PROC));
+            {
+                std::lock_guard<std::mutex> lg(screensMutex);
+                screens.push_back(std::move(proc));
+                registerProcessStatus(screens.back());
+            }
+        }
+        std::cout << "Generated " << n << " processes!\n";
+    }
+    else if (command[0] == "report-util")
+    {
+        namespace fs = std::filesystem;
+        std::ofstream writeReport(report_file_name);
+        writeReport << report_util;
+        writeReport.close();
+        std::cout << "Report generated at " << fs::path(report_file_name) << "!\n";
+        report_util.clear();
+    }
+    else if (command[0] == "print")
+    {
+        if (isPrinting)
+        {
+            // std::cout << "Print job already running.\n";
+        }
+        else
+        {
+            stopScheduler = false; // reset in case of re-run
+            printThread = std::thread(startPrintJob, std::ref(screens));
+            printThread.detach(); // run in background
+            // std::cout << "Print job started in background.\n";
+        }
+    }
+    else if ((command[0] == "initialize"))
+    {
+        if (replacementPolicy)
+        {
+            PagingStats &stats = pagingStatsByPolicy[replacementPolicy->name()];
+            stats.accesses += pageAccesses.load();
+            stats.faults += pagesPagedIn.load();
+        }
+        pageAccesses = 0;
+        totalTicks = 0;
+        activeTicks = 0;
+        idleTicks = 0;
+        pagesPagedIn = 0;
+        pagesPagedOut = 0;
+        pagesWrittenBack = 0;
+        pagesDroppedClean = 0;
+        std::cout << command[0] << " command recognized. Doing something.\n";
+        readConfigFile(configFile);
+        resetTrace();
+        stopSnapshotWriter(); // reopened below with the new snapshot-format
+        startSnapshotWriter();
+        startLogFlusher();
+        if (clockMode == "virtual")
+            stopSleepTicker(); // the virtual scheduler advances the wheel itself
+        else
+            startSleepTicker();
+        isInitialized = true;
+    }
+    else if (command[0] == "scheduler-test" && currentScreen.name == "Main Menu")
+    {
+        std::cout << "Starting scheduler test...\n";
 
-                if (proc.instructions.size() < 1 || proc.instructions.size() > 50)
-                {
-                    std::cout << "Number of instructions should be between 1-50\n";
+        std::thread testThread([&screens]()
+                               {
+            int nextPid = 1;
+            int count = 5; 
+            for (int i = 0; i < count; ++i)
+            {
+                ExecutableScreen exec{};
+                exec.pid = nextProcessId++;
+                exec.name = "test" + std::to_string(nextPid++);
+                exec.createdDate = getCurrentDateTime();
+
+                int memSize;
+                do {
+                    memSize = getRand(MIN_MEM_PER_PROC, MAX_MEM_PER_PROC);
+                } while (!isPowerOfTwo(memSize));
+                loadProgram(exec, drawGeneratedProgram(memSize));
+
+                if (!allocateProcessMemory(exec, memSize)) {
+                    std::cout << "[scheduler-test] No memory for " << exec.name << ", skipping.\n";
+                    std::this_thread::sleep_for(std::chrono::milliseconds(batchFreq * delayPerExec));
                     continue;
                 }
 
-                proc.totalLines = static_cast<int>(proc.instructions.size());
-
-                proc.memorySize = memSize;
-                int allocStart = allocateMemory(procName, memSize);
-                if (allocStart == -1)
-                {
-                    std::cout << "Memory allocation failed.\n";
-                    return 0;
-                }
-
                 {
                     std::lock_guard<std::mutex> lg(screensMutex);
-                    screens.push_back(std::move(proc));
-                    ExecutableScreen *p = &screens.back();
-                    {
-                        std::lock_guard<std::mutex> ql(queueMutex);
-                        readyQueue.push(p);
-                    }
-                    cv.notify_one();
+                    screens.push_back(std::move(exec));
+                    registerProcessStatus(screens.back());
+                    ExecutableScreen* p = &screens.back();
+                    enqueueReady(p);
                 }
 
-                if (!isPrinting)
-                {
-                    isPrinting = true;
-                    stopScheduler = false;
-                    for (int i = 0; i < CPU_CORES; ++i)
-                    {
-                        cpuThreads.emplace_back(cpuWorker, i);
-                    }
-                }
+                std::cout << "[scheduler-test] Generated process " << exec.name << " with " 
+                        << memSize << " bytes and " << exec.totalLines << " instructions.\n";
 
-                currentScreen = screens.back();
-                clearScreen();
-                printScreen(currentScreen);
-            }
+                std::this_thread::sleep_for(std::chrono::milliseconds(batchFreq * delayPerExec));
+            } });
+
+        testThread.detach();
+
+        if (clockMode == "virtual")
+        {
+            startVirtualScheduler(screens);
         }
-        else if (command[0] == "generate" && command.size() == 2)
+        else if (!isPrinting)
         {
-            int n = std::stoi(command[1]);
-            for (int i = 0; i < n; ++i)
+            isPrinting = true;
+            stopScheduler = false;
+            for (int i = 0; i < CPU_CORES; ++i)
             {
-                std::string pname = "p" + std::to_string(i + 1);
-                ExecutableScreen proc = createScreen(pname);
-                proc.instructions = generateRandomInstructions(
-                    getRand(minInstructions, maxInstructions), pname);
-                proc.totalLines = static_cast<int>(proc.instructions.size());
-                {
-                    std::lock_guard<std::mutex> lg(screensMutex);
-                    screens.push_back(std::move(proc));
-                }
+                cpuThreads.emplace_back(cpuWorker, i);
             }
-            std::cout << "Generated " << n << " processes!\n";
         }
-        else if (command[0] == "report-util")
-        {
-            namespace fs = std::filesystem;
-            std::ofstream writeReport(report_file_name);
-            writeReport << report_util;
-            writeReport.close();
-            std::cout << "Report generated at " << fs::path(report_file_name) << "!\n";
-            report_util.clear();
-        }
-        else if (command[0] == "print")
+    }
+
+    else if (command[0] == "scheduler-stop" && currentScreen.name == "Main Menu")
+    {
+        std::cout << command[0] << " command recognized. Doing something.\n";
+    }
+    else
+    {
+        std::cout << "Unknown command: " << cmd << "\n";
+    }
+    return true;
+}
+
+// One line of a --batch script: a shell command, or one of the batch-only directives
+//   wait <ms>                       sleep on the wall clock
+//   wait-finished <n> [timeout-ms]  block until n processes have exited in total
+//   wait-scheduler [timeout-ms]     block until the scheduler has stopped and drained, e.g. at max-ticks
+// Blank lines and lines starting with '#' are skipped.
+bool runBatchLine(ShellState &shell, const std::string &line)
+{
+    std::istringstream in(line);
+    std::string directive;
+    in >> directive;
+    if (directive.empty() || directive[0] == '#')
+        return true;
+
+    std::cout << "> " << line << "\n";
+    if (directive == "wait")
+    {
+        int ms = 0;
+        in >> ms;
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+        return true;
+    }
+    if (directive == "wait-finished")
+    {
+        int target = 0;
+        long long timeoutMs = -1;
+        in >> target >> timeoutMs;
+        auto start = std::chrono::steady_clock::now();
+        while (processesFinished.load() < target)
         {
-            if (isPrinting)
-            {
-                // std::cout << "Print job already running.\n";
-            }
-            else
+            if (timeoutMs >= 0 && std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(timeoutMs))
             {
-                stopScheduler = false; // reset in case of re-run
-                printThread = std::thread(startPrintJob, std::ref(screens));
-                printThread.detach(); // run in background
-                // std::cout << "Print job started in background.\n";
+                std::cout << "wait-finished: timed out at " << processesFinished.load() << "/" << target << " processes.\n";
+                break;
             }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
         }
-        else if ((command[0] == "initialize"))
+        return true;
+    }
+    if (directive == "wait-scheduler")
+    {
+        long long timeoutMs = -1;
+        in >> timeoutMs;
+        auto start = std::chrono::steady_clock::now();
+        while (schedulerBusy())
         {
-            totalTicks = 0;
-            activeTicks = 0;
-            idleTicks = 0;
-            pagesPagedIn = 0;
-            pagesPagedOut = 0;
-            std::cout << command[0] << " command recognized. Doing something.\n";
-            readConfigFile("config.txt");
-            isInitialized = true;
+            if (timeoutMs >= 0 && std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(timeoutMs))
+            {
+                std::cout << "wait-scheduler: timed out at tick " << virtualTick.load() << ".\n";
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
         }
-        else if (command[0] == "scheduler-test" && currentScreen.name == "Main Menu")
-        {
-            std::cout << "Starting scheduler test...\n";
+        return true;
+    }
+    return handleCommand(shell, line);
+}
 
-            std::thread testThread([&screens]()
-                                   {
-                int nextPid = 1;
-                int count = 5; 
-                for (int i = 0; i < count; ++i)
-                {
-                    ExecutableScreen exec{};
-                    exec.name = "test" + std::to_string(nextPid++);
-                    exec.instructions = generateRandomInstructions(getRand(minInstructions, maxInstructions), exec.name);
-                    exec.totalLines = static_cast<int>(exec.instructions.size());
-                    exec.createdDate = getCurrentDateTime();
-
-                    int memSize;
-                    do {
-                        memSize = getRand(MIN_MEM_PER_PROC, MAX_MEM_PER_PROC);
-                    } while (!isPowerOfTwo(memSize));
-
-                    int allocStart = allocateMemory(exec.name, memSize);
-                    exec.memorySize = memSize;
-
-                    if (allocStart == -1) {
-                        std::cout << "[scheduler-test] No memory for " << exec.name << ", skipping.\n";
-                        std::this_thread::sleep_for(std::chrono::milliseconds(batchFreq * delayPerExec));
-                        continue;
-                    }
+// Machine-readable results of a batch run; tick and paging counters are those since the last
+// initialize, processes_finished counts every exit since startup
+std::string batchSummaryJson(double wallSeconds)
+{
+    long long instructions = activeTicks.load();
+    std::ostringstream json;
+    json << std::fixed << std::setprecision(3);
+    json << "{\n"
+         << "  \"config\": \"" << jsonEscape(configFile) << "\",\n"
+         << "  \"scheduler\": \"" << jsonEscape(schedulerPolicy->name()) << "\",\n"
+         << "  \"page_replacement\": \"" << jsonEscape(pageReplacementAlgo) << "\",\n"
+         << "  \"clock_mode\": \"" << jsonEscape(clockMode) << "\",\n"
+         << "  \"num_cpu\": " << CPU_CORES << ",\n"
+         << "  \"wall_seconds\": " << wallSeconds << ",\n"
+         << "  \"processes_finished\": " << processesFinished.load() << ",\n"
+         << "  \"instructions\": " << instructions << ",\n"
+         << "  \"instructions_per_sec\": " << (wallSeconds > 0 ? instructions / wallSeconds : 0.0) << ",\n"
+         << "  \"total_ticks\": " << totalTicks.load() << ",\n"
+         << "  \"active_ticks\": " << activeTicks.load() << ",\n"
+         << "  \"idle_ticks\": " << idleTicks.load() << ",\n"
+         << "  \"virtual_ticks\": " << virtualTick.load() << ",\n"
+         << "  \"page_accesses\": " << pageAccesses.load() << ",\n"
+         << "  \"page_faults\": " << pagesPagedIn.load() << ",\n"
+         << "  \"pages_paged_out\": " << pagesPagedOut.load() << ",\n"
+         << "  \"scheduling\": {";
+
+    std::map<std::string, SchedulingStats> byPolicy;
+    {
+        std::lock_guard<std::mutex> statsLock(schedulingStatsMutex);
+        byPolicy = schedulingStatsByPolicy;
+    }
+    bool first = true;
+    for (const auto &kv : byPolicy)
+    {
+        const SchedulingStats &st = kv.second;
+        json << (first ? "\n" : ",\n")
+             << "    \"" << jsonEscape(kv.first) << "\": {\"completed\": " << st.completed
+             << ", \"avg_turnaround_ms\": " << st.turnaroundMs / st.completed
+             << ", \"avg_waiting_ms\": " << st.waitingMs / st.completed
+             << ", \"avg_response_ms\": " << st.responseMs / st.completed << "}";
+        first = false;
+    }
+    json << (first ? "}\n" : "\n  }\n") << "}\n";
+    return json.str();
+}
 
-                    {
-                        std::lock_guard<std::mutex> lg(screensMutex);
-                        screens.push_back(std::move(exec));
-                        ExecutableScreen* p = &screens.back();
-                        {
-                            std::lock_guard<std::mutex> ql(queueMutex);
-                            readyQueue.push(p);
-                        }
-                        cv.notify_one();
-                    }
+// --batch <config> <script> [--summary <file>]: runs the script without a prompt, shuts the
+// simulator down, and prints the JSON summary (or writes it to the --summary file)
+int runBatch(const std::string &config, const std::string &scriptPath, const std::string &summaryPath)
+{
+    std::ifstream script(scriptPath);
+    if (!script)
+    {
+        std::cerr << "Error opening " << scriptPath << "\n";
+        return 1;
+    }
+    configFile = config;
 
-                    std::cout << "[scheduler-test] Generated process " << exec.name << " with " 
-                            << memSize << " bytes and " << exec.totalLines << " instructions.\n";
+    ShellState shell;
+    shell.mainMenu.name = "Main Menu";
+    shell.currentScreen = shell.mainMenu;
 
-                    std::this_thread::sleep_for(std::chrono::milliseconds(batchFreq * delayPerExec));
-                } });
+    auto start = std::chrono::steady_clock::now();
+    bool running = true;
+    std::string line;
+    while (running && std::getline(script, line))
+        running = runBatchLine(shell, line);
 
-            testThread.detach();
+    // Leave any attached screen, then stop the scheduler and drain the cores
+    if (running && shell.isInitialized)
+    {
+        if (shell.currentScreen.name != "Main Menu")
+            handleCommand(shell, "exit");
+        handleCommand(shell, "exit");
+    }
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stopSleepTicker();
+    stopSnapshotWriter();
+    stopLogFlusher();
 
-            if (!isPrinting)
-            {
-                isPrinting = true;
-                stopScheduler = false;
-                for (int i = 0; i < CPU_CORES; ++i)
-                {
-                    cpuThreads.emplace_back(cpuWorker, i);
-                }
-            }
-        }
+    if (!shell.isInitialized)
+    {
+        std::cerr << "Batch script never ran initialize.\n";
+        return 1;
+    }
+    std::string summary = batchSummaryJson(wallSeconds);
+    if (summaryPath.empty())
+    {
+        std::cout << summary;
+    }
+    else
+    {
+        std::ofstream out(summaryPath, std::ios::trunc);
+        out << summary;
+        std::cout << "Summary written to " << summaryPath << "\n";
+    }
+    return 0;
+}
 
-        else if (command[0] == "scheduler-stop" && currentScreen.name == "Main Menu")
-        {
-            std::cout << command[0] << " command recognized. Doing something.\n";
-        }
-        else
+int main(int argc, char *argv[])
+{
+    if (argc >= 4 && std::string(argv[1]) == "--batch")
+    {
+        std::string summaryPath;
+        if (argc >= 6 && std::string(argv[4]) == "--summary")
+            summaryPath = argv[5];
+        return runBatch(argv[2], argv[3], summaryPath);
+    }
+
+    ShellState shell;
+    shell.mainMenu.name = "Main Menu";
+    shell.currentScreen = shell.mainMenu;
+    printHeader();
+    std::string cmd;
+
+    while (true)
+    {
+        std::cout << "Enter a command: ";
+        if (!std::getline(std::cin, cmd))
         {
-            std::cout << "Unknown command: " << cmd << "\n";
+            // End of input shuts down like `exit` so the generator and cores are joined
+            if (shell.isInitialized)
+            {
+                if (shell.currentScreen.name != "Main Menu")
+                    handleCommand(shell, "exit");
+                handleCommand(shell, "exit");
+            }
+            break;
         }
+        if (!handleCommand(shell, cmd))
+            break;
     }
+    stopSleepTicker();
+    stopSnapshotWriter();
+    stopLogFlusher();
     return 0;
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,396 @@
+// Microbenchmarks for the allocator, pager and interpreter hot paths.
+//
+// Build: g++ -std=c++17 -O2 -pthread microbench.cpp -o os_microbench
+// Usage: ./os_microbench [--filter SUBSTRING] [--min-time MS]
+//                        [--mem-sizes 65536,1048576] [--frame-sizes 16,64]
+//                        [--processes 16,256] [--instructions 100,1000]
+//
+// Each case calls one subsystem directly, outside the REPL and the scheduler
+// threads, and reports ns/op and heap allocations/op (operator new calls).
+
+#define CSOPESY_NO_MAIN
+#include "main.cpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <new>
+
+std::atomic<long long> heapAllocations{0};
+
+// The whole replaceable new/delete family goes through these two, so every allocation form
+// (array, nothrow, aligned) is counted and every delete matches its new
+void *countedAlloc(size_t size, size_t alignment = 0)
+{
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0)
+        size = 1;
+    if (alignment <= alignof(std::max_align_t))
+        return std::malloc(size);
+#ifdef _WIN32
+    return _aligned_malloc(size, alignment);
+#else
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+}
+
+void countedFree(void *p, size_t alignment = 0) noexcept
+{
+#ifdef _WIN32
+    if (alignment > alignof(std::max_align_t))
+    {
+        _aligned_free(p);
+        return;
+    }
+#else
+    (void)alignment;
+#endif
+    std::free(p);
+}
+
+void *countedAllocOrThrow(size_t size, size_t alignment = 0)
+{
+    if (void *p = countedAlloc(size, alignment))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new(size_t size) { return countedAllocOrThrow(size); }
+void *operator new[](size_t size) { return countedAllocOrThrow(size); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept { return countedAlloc(size); }
+void *operator new[](size_t size, const std::nothrow_t &) noexcept { return countedAlloc(size); }
+void *operator new(size_t size, std::align_val_t al) { return countedAllocOrThrow(size, static_cast<size_t>(al)); }
+void *operator new[](size_t size, std::align_val_t al) { return countedAllocOrThrow(size, static_cast<size_t>(al)); }
+void *operator new(size_t size, std::align_val_t al, const std::nothrow_t &) noexcept { return countedAlloc(size, static_cast<size_t>(al)); }
+void *operator new[](size_t size, std::align_val_t al, const std::nothrow_t &) noexcept { return countedAlloc(size, static_cast<size_t>(al)); }
+
+void operator delete(void *p) noexcept { countedFree(p); }
+void operator delete[](void *p) noexcept { countedFree(p); }
+void operator delete(void *p, size_t) noexcept { countedFree(p); }
+void operator delete[](void *p, size_t) noexcept { countedFree(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { countedFree(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { countedFree(p); }
+void operator delete(void *p, std::align_val_t al) noexcept { countedFree(p, static_cast<size_t>(al)); }
+void operator delete[](void *p, std::align_val_t al) noexcept { countedFree(p, static_cast<size_t>(al)); }
+void operator delete(void *p, size_t, std::align_val_t al) noexcept { countedFree(p, static_cast<size_t>(al)); }
+void operator delete[](void *p, size_t, std::align_val_t al) noexcept { countedFree(p, static_cast<size_t>(al)); }
+void operator delete(void *p, std::align_val_t al, const std::nothrow_t &) noexcept { countedFree(p, static_cast<size_t>(al)); }
+void operator delete[](void *p, std::align_val_t al, const std::nothrow_t &) noexcept { countedFree(p, static_cast<size_t>(al)); }
+
+struct MicrobenchOptions
+{
+    std::string filter;
+    double minTimeMs = 200;
+    std::vector<int> memSizes = {65536, 1048576};
+    std::vector<int> frameSizes = {16, 64};
+    std::vector<int> processCounts = {16, 256};
+    std::vector<int> instructionCounts = {100, 1000};
+};
+
+MicrobenchOptions options;
+
+// Runs `op` in growing batches until one batch takes at least --min-time, then reports that batch
+void runCase(const std::string &name, const std::function<void()> &op)
+{
+    if (!options.filter.empty() && name.find(options.filter) == std::string::npos)
+        return;
+
+    op(); // warm-up: first touches, lazy allocations
+    long long iterations = 1;
+    while (true)
+    {
+        long long allocsBefore = heapAllocations.load(std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+        for (long long i = 0; i < iterations; ++i)
+            op();
+        double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        long long allocs = heapAllocations.load(std::memory_order_relaxed) - allocsBefore;
+
+        if (elapsedMs >= options.minTimeMs || iterations >= (1LL << 40))
+        {
+            std::cout << std::left << std::setw(52) << name
+                      << std::setw(12) << iterations
+                      << std::setw(14) << std::fixed << std::setprecision(1) << elapsedMs * 1e6 / iterations
+                      << std::setprecision(2) << static_cast<double>(allocs) / iterations << "\n";
+            return;
+        }
+        // Aim past the target from the last measurement, growing at most 10x per round
+        double scale = elapsedMs > 0 ? options.minTimeMs * 1.2 / elapsedMs : 10;
+        iterations = static_cast<long long>(iterations * std::max(2.0, std::min(10.0, scale)));
+    }
+}
+
+int floorPowerOfTwo(int x)
+{
+    int p = 1;
+    while (p * 2 <= x)
+        p *= 2;
+    return p;
+}
+
+// allocateMemory + freeMemory of one extra process with `processes` others resident, so
+// first-fit scans past every block and buddy splits and merges down from the free tail
+void benchAllocator(const std::string &algo, int memSize, int processes)
+{
+    int blockSize = std::max(64, floorPowerOfTwo(memSize / (2 * processes)));
+    if (static_cast<long long>(blockSize) * (processes + 1) > memSize)
+        return;
+
+    memAllocatorAlgo = algo;
+    MEM_TOTAL = memSize;
+    {
+        std::lock_guard<std::mutex> lock(memMutex);
+        memoryAllocator = makeMemoryAllocator(algo, MEM_TOTAL);
+    }
+    for (int i = 0; i < processes; ++i)
+        allocateMemory("resident" + std::to_string(i), blockSize);
+
+    const std::string probe = "probe";
+    runCase("alloc/" + algo + "/mem:" + std::to_string(memSize) + "/procs:" + std::to_string(processes),
+            [&]
+            {
+                allocateMemory(probe, blockSize);
+                freeMemory(probe);
+            });
+}
+
+// One page fault per op: `processes` processes touch their pages round-robin with twice as many
+// pages as frames, so under fifo every load evicts. Dirty pages are written to the backing store.
+void benchPager(int memSize, int frameSize, int processes, bool dirty)
+{
+    MEM_TOTAL = memSize;
+    MEM_FRAME_SIZE = frameSize;
+    pageReplacementAlgo = "fifo";
+    pageTraceFile = "";
+    initializeMemorySystem();
+
+    int totalFrames = MEM_TOTAL / MEM_FRAME_SIZE;
+    int pagesPerProcess = std::max(1, 2 * totalFrames / processes);
+    std::deque<ExecutableScreen> procs; // stable addresses for the frame table's owner pointers
+    for (int i = 0; i < processes; ++i)
+    {
+        ExecutableScreen &proc = procs.emplace_back(createScreen("pager" + std::to_string(i)));
+        proc.memorySize = pagesPerProcess * MEM_FRAME_SIZE;
+        proc.memoryLimit = proc.memorySize;
+        proc.pageTable.assign(pagesPerProcess, {});
+    }
+
+    int nextProc = 0;
+    int nextPage = 0;
+    runCase(std::string("pager/") + (dirty ? "dirty" : "clean") + "/mem:" + std::to_string(memSize) +
+                "/frame:" + std::to_string(frameSize) + "/procs:" + std::to_string(processes),
+            [&]
+            {
+                ExecutableScreen &proc = procs[nextProc];
+                {
+                    std::lock_guard<std::mutex> pagerLock(pagerMutex);
+                    std::lock_guard<CopyableMutex> pin(proc.pageTableMutex);
+                    if (!proc.pageTable[nextPage].present)
+                        loadPageIntoFrame(proc, nextPage);
+                    proc.pageTable[nextPage].dirty = dirty;
+                }
+                if (++nextProc == processes)
+                {
+                    nextProc = 0;
+                    nextPage = (nextPage + 1) % pagesPerProcess;
+                }
+            });
+
+    for (auto &proc : procs)
+    {
+        releaseProcessFrames(proc);
+        releaseBackingStore(proc);
+    }
+}
+
+// `count` instructions of one kind, addresses kept inside memSize
+std::vector<Instruction> makeInstructionMix(const std::string &mix, int count, int memSize)
+{
+    if (mix == "random")
+        return generateRandomInstructions(count, memSize);
+
+    std::vector<std::string> vars = {"x", "y", "z"};
+    std::vector<Instruction> instructions;
+    for (int i = 0; i < count; ++i)
+    {
+        const std::string &var = vars[i % vars.size()];
+        if (mix == "arith")
+        {
+            Instruction inst{i % 3 == 0 ? InstructionType::DECLARE : (i % 3 == 1 ? InstructionType::ADD : InstructionType::SUBTRACT)};
+            inst.var1 = var;
+            inst.var2 = vars[(i + 1) % vars.size()];
+            inst.var3 = "1";
+            inst.value = static_cast<uint16_t>(i);
+            instructions.push_back(inst);
+        }
+        else if (mix == "print")
+        {
+            Instruction inst{InstructionType::PRINT};
+            inst.message = "Value from " + PROCESS_NAME_TOKEN + ": ";
+            inst.var1 = var;
+            instructions.push_back(inst);
+        }
+        else if (mix == "memory")
+        {
+            Instruction inst{i % 2 == 0 ? InstructionType::WRITE : InstructionType::READ};
+            int base = memSize > SYMBOL_TABLE_BYTES ? SYMBOL_TABLE_BYTES : 0; // past the variables when there is room
+            std::string address = toHexAddress(base + (i * 2) % (memSize - base));
+            inst.var1 = inst.type == InstructionType::WRITE ? address : var;
+            inst.var2 = inst.type == InstructionType::WRITE ? var : address;
+            instructions.push_back(inst);
+        }
+    }
+    return instructions;
+}
+
+// The same instructions as a screen -c script, for the parser
+std::string renderInstructionScript(const std::vector<Instruction> &instructions)
+{
+    std::string script;
+    for (const Instruction &inst : instructions)
+    {
+        if (!script.empty())
+            script += "; ";
+        switch (inst.type)
+        {
+        case InstructionType::DECLARE:
+            script += "DECLARE " + inst.var1 + " " + std::to_string(inst.value);
+            break;
+        case InstructionType::ADD:
+        case InstructionType::SUBTRACT:
+            script += std::string(inst.type == InstructionType::ADD ? "ADD " : "SUBTRACT ") + inst.var1 + " " + inst.var2 + " " + inst.var3;
+            break;
+        case InstructionType::PRINT:
+            script += "PRINT(\"" + inst.message + "\" + " + inst.var1 + ")";
+            break;
+        case InstructionType::SLEEP:
+            script += "SLEEP " + std::to_string(inst.sleepTicks);
+            break;
+        case InstructionType::WRITE:
+        case InstructionType::READ:
+            script += std::string(inst.type == InstructionType::WRITE ? "WRITE " : "READ ") + inst.var1 + " " + inst.var2;
+            break;
+        case InstructionType::FOR:
+            script += "FOR([" + renderInstructionScript(inst.subInstructions) + "], " + std::to_string(inst.repeatCount) + ")";
+            break;
+        default:
+            break;
+        }
+    }
+    return script;
+}
+
+void benchParser(const std::string &mix, int count)
+{
+    std::string script = renderInstructionScript(makeInstructionMix(mix, count, 4096));
+    runCase("parse/" + mix + "/ins:" + std::to_string(count), [&]
+            { parseInstructionString(script); });
+}
+
+void benchGenerator(int count, int memSize)
+{
+    runCase("generate/ins:" + std::to_string(count) + "/mem:" + std::to_string(memSize), [&]
+            { generateRandomInstructions(count, memSize); });
+}
+
+// One executeInstruction per op on a resident process: the instruction switch cpuWorker runs,
+// without the scheduler, log flusher or exec delay around it. `logged` also builds each log line,
+// as with log-instructions true; the /log cases carry that suffix.
+void benchInterpreter(const std::string &mix, int memSize, bool logged)
+{
+    MEM_TOTAL = 65536;
+    MEM_FRAME_SIZE = 16;
+    pageReplacementAlgo = "fifo";
+    initializeMemorySystem();
+
+    ExecutableScreen proc = createScreen("interp");
+    if (!allocateProcessMemory(proc, memSize))
+        return;
+    auto program = std::make_shared<const Program>(compileProgram(makeInstructionMix(mix, 256, memSize)));
+    loadProgram(proc, program);
+
+    std::string logEntry;
+    runCase("interpret/" + mix + "/mem:" + std::to_string(memSize) + (logged ? "/log" : ""), [&]
+            {
+                if (proc.instructionPointer >= static_cast<int>(proc.program->code.size()))
+                    loadProgram(proc, program);
+                int sleepTicks = 0;
+                executeInstruction(proc, 0, logged ? &logEntry : nullptr, sleepTicks);
+            });
+
+    releaseProcessFrames(proc);
+    releaseBackingStore(proc);
+    freeMemory(proc.name);
+}
+
+std::vector<int> parseIntList(const std::string &text)
+{
+    std::vector<int> values;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ','))
+        values.push_back(std::stoi(item));
+    return values;
+}
+
+int main(int argc, char *argv[])
+{
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        if (arg == "--filter")
+            options.filter = argv[i + 1];
+        else if (arg == "--min-time")
+            options.minTimeMs = std::stod(argv[i + 1]);
+        else if (arg == "--mem-sizes")
+            options.memSizes = parseIntList(argv[i + 1]);
+        else if (arg == "--frame-sizes")
+            options.frameSizes = parseIntList(argv[i + 1]);
+        else if (arg == "--processes")
+            options.processCounts = parseIntList(argv[i + 1]);
+        else if (arg == "--instructions")
+            options.instructionCounts = parseIntList(argv[i + 1]);
+    }
+
+    // The swap file and any stray output go to a scratch directory
+    std::filesystem::path workDir = std::filesystem::temp_directory_path() / "csopesy-microbench";
+    std::filesystem::remove_all(workDir);
+    std::filesystem::create_directories(workDir);
+    std::filesystem::current_path(workDir);
+    output_dir = workDir.string();
+    logInstructions = false;
+    seedRandom(42);
+
+    std::cout << std::left << std::setw(52) << "case"
+              << std::setw(12) << "iterations"
+              << std::setw(14) << "ns/op"
+              << "allocs/op\n";
+    std::cout << std::string(88, '-') << "\n";
+
+    for (const std::string algo : {"first-fit", "buddy"})
+        for (int memSize : options.memSizes)
+            for (int processes : options.processCounts)
+                benchAllocator(algo, memSize, processes);
+
+    for (bool dirty : {false, true})
+        for (int memSize : options.memSizes)
+            for (int frameSize : options.frameSizes)
+                for (int processes : options.processCounts)
+                    benchPager(memSize, frameSize, processes, dirty);
+
+    for (const std::string mix : {"arith", "print", "memory", "random"})
+        for (int count : options.instructionCounts)
+            benchParser(mix, count);
+
+    for (int count : options.instructionCounts)
+        for (int memSize : {64, 4096})
+            benchGenerator(count, memSize);
+
+    for (const std::string mix : {"arith", "print", "memory", "random"})
+        for (int memSize : {64, 4096})
+        {
+            benchInterpreter(mix, memSize, false);
+            benchInterpreter(mix, memSize, true);
+        }
+    return 0;
+}
@@ -0,0 +1,307 @@
+// Regression tests for inputs that once crashed or corrupted the simulator.
+//
+// Build: g++ -std=c++17 -O2 -pthread tests.cpp -o os_tests
+// Usage: ./os_tests    (exit status is the number of failed checks)
+
+#define CSOPESY_NO_MAIN
+#include "main.cpp"
+
+#include <filesystem>
+
+int failures = 0;
+
+#define CHECK(cond)                                                              \
+    do                                                                           \
+    {                                                                            \
+        if (!(cond))                                                             \
+        {                                                                        \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond "\n"; \
+            failures++;                                                          \
+        }                                                                        \
+    } while (0)
+
+// Runs `proc` to completion on core 0 and returns its log lines
+std::vector<std::string> runToEnd(ExecutableScreen &proc)
+{
+    std::vector<std::string> logLines;
+    while (proc.instructionPointer < static_cast<int>(proc.program->code.size()))
+    {
+        std::string logEntry;
+        int sleepTicks = 0;
+        if (!executeInstruction(proc, 0, &logEntry, sleepTicks))
+            break;
+        logLines.push_back(logEntry);
+    }
+    return logLines;
+}
+
+ExecutableScreen compileScript(const std::string &name, const std::string &script)
+{
+    ExecutableScreen proc = createScreen(name);
+    loadProgram(proc, std::make_shared<const Program>(compileProgram(parseInstructionString(script))));
+    allocateProcessMemory(proc, 64);
+    return proc;
+}
+
+// Literals past int range used to throw std::out_of_range out of compileProgram
+void testOutOfRangeLiterals()
+{
+    ExecutableScreen add = compileScript("add", "DECLARE x 5; ADD x x 99999999999");
+    CHECK(add.program->code.size() == 2);
+    std::vector<std::string> addLog = runToEnd(add);
+    CHECK(addLog.size() == 2);
+    CHECK(!addLog.empty() && addLog.back() == "Added: x = 5"); // the literal reads as an undeclared 0
+
+    ExecutableScreen write = compileScript("write", "WRITE 0x20 99999999999");
+    std::vector<std::string> writeLog = runToEnd(write);
+    CHECK(writeLog.size() == 1);
+    CHECK(!writeLog.empty() && writeLog[0] == "WRITE failed: value not found.");
+
+    ExecutableScreen negative = compileScript("negative", "DECLARE x 5; SUBTRACT x x -99999999999");
+    std::vector<std::string> negativeLog = runToEnd(negative);
+    CHECK(!negativeLog.empty() && negativeLog.back() == "Subtracted: x = 5");
+
+    ExecutableScreen inRange = compileScript("inrange", "DECLARE x 5; ADD x x 70000");
+    std::vector<std::string> inRangeLog = runToEnd(inRange);
+    CHECK(!inRangeLog.empty() && inRangeLog.back() == "Added: x = " + std::to_string(static_cast<uint16_t>(5 + 70000)));
+}
+
+// FOR counts were read with find_first_of + atoi, so -3 ran three times and 99999999999 overflowed
+void testForRepeatCount()
+{
+    std::vector<Instruction> three = parseInstructionString("FOR([DECLARE x 1], 3)");
+    CHECK(three.size() == 1 && three[0].repeatCount == 3);
+    CHECK(parseInstructionString("FOR([DECLARE x 1], -3)").empty());
+    CHECK(parseInstructionString("FOR([DECLARE x 1], 99999999999)").empty());
+    CHECK(parseInstructionString("FOR([DECLARE x 1], -3); DECLARE y 2").size() == 1);
+}
+
+// screen -r used to read variables through the snapshot's stale page table, so a frame reused by
+// another process after the snapshot showed that process's data
+void testSnapshotSurvivesEviction()
+{
+    int savedTotal = MEM_TOTAL;
+    int savedFrame = MEM_FRAME_SIZE;
+    MEM_TOTAL = 128;
+    MEM_FRAME_SIZE = 128; // one frame, so the second process evicts the first
+    initializeMemorySystem();
+
+    ExecutableScreen first = compileScript("first", "DECLARE x 7");
+    runToEnd(first);
+    ExecutableScreen snapshot = snapshotScreen(first);
+
+    ExecutableScreen second = compileScript("second", "DECLARE y 9");
+    runToEnd(second);
+    CHECK(!first.pageTable[0].present);
+
+    std::ostringstream printed;
+    std::streambuf *saved = std::cout.rdbuf(printed.rdbuf());
+    printScreen(snapshot);
+    std::cout.rdbuf(saved);
+    CHECK(printed.str().find("  x = 7\n") != std::string::npos);
+
+    MEM_TOTAL = savedTotal;
+    MEM_FRAME_SIZE = savedFrame;
+    initializeMemorySystem();
+}
+
+// Batch summaries and traces embed config paths and process names in JSON strings
+void testJsonEscape()
+{
+    CHECK(jsonEscape("plain") == "plain");
+    CHECK(jsonEscape("a\"b\\c") == "a\\\"b\\\\c");
+    CHECK(jsonEscape("line\nbreak\x01") == "line\\nbreak\\u0001");
+}
+
+// Status rows used to be appended per process forever, even after the process was compacted
+void testStatusSlotsRecycled()
+{
+    int savedRetain = retainFinished;
+    retainFinished = 0;
+    std::deque<ExecutableScreen> screens;
+    for (int i = 0; i < 5; ++i)
+    {
+        std::lock_guard<std::mutex> lock(screensMutex);
+        retireFinishedScreens(screens);
+        screens.push_back(compileScript("recycled" + std::to_string(i), "DECLARE x 1"));
+        registerProcessStatus(screens.back());
+        ExecutableScreen &proc = screens.back();
+        runToEnd(proc);
+        finishProcess(proc, "fcfs");
+    }
+    CHECK(statusTable.size() == 1); // each process is compacted before the next registers, so one slot serves all five
+
+    std::vector<ProcessStatusView> rows = snapshotProcessStatus();
+    CHECK(rows.size() == 5);
+    for (size_t i = 0; i < rows.size(); ++i)
+        CHECK(rows[i].name == "recycled" + std::to_string(i));
+
+    {
+        std::lock_guard<std::mutex> lock(screensMutex);
+        retireFinishedScreens(screens);
+    }
+    retainFinished = savedRetain;
+}
+
+// A shut down process has its finishedTime set during the faulting instruction; compacting it before its
+// core reached finishProcess freed the page table its resident frames still pointed into
+void testShutdownNotCompactedEarly()
+{
+    int savedRetain = retainFinished;
+    retainFinished = 0;
+    std::deque<ExecutableScreen> screens;
+    screens.push_back(compileScript("faulting", "DECLARE x 1; WRITE 0x500 1"));
+    screens.push_back(compileScript("done", "DECLARE y 2"));
+    ExecutableScreen &faulting = screens[0];
+    ExecutableScreen &done = screens[1];
+
+    int sleepTicks = 0;
+    CHECK(stepProcess(faulting, 0, sleepTicks));  // DECLARE faults page 0 in
+    CHECK(!stepProcess(faulting, 0, sleepTicks)); // WRITE past the limit shuts it down
+    CHECK(faulting.isShutdown && !faulting.finishedTime.empty());
+    runToEnd(done);
+    finishProcess(done, "fcfs");
+
+    {
+        std::lock_guard<std::mutex> lock(screensMutex);
+        retireFinishedScreens(screens);
+    }
+    CHECK(screens.size() == 2);
+    CHECK(!faulting.compacted && done.compacted);
+
+    finishProcess(faulting, "fcfs");
+    CHECK(freeFrameCount == static_cast<int>(frameTable.size()));
+    {
+        std::lock_guard<std::mutex> lock(screensMutex);
+        retireFinishedScreens(screens);
+    }
+    CHECK(screens.empty());
+    retainFinished = savedRetain;
+}
+
+// MLFQ demotion was one-way, so new level-0 arrivals could keep a demoted process off the cores forever
+void testMlfqBoost()
+{
+    std::unique_ptr<SchedulerPolicy> saved = std::move(schedulerPolicy);
+    schedulerPolicy = makeSchedulerPolicy("mlfq");
+
+    ExecutableScreen demoted = createScreen("demoted");
+    ExecutableScreen arrival = createScreen("arrival");
+    ExecutableScreen running = createScreen("running");
+    demoted.queueLevel = MLFQ_LEVELS - 1;
+    running.queueLevel = MLFQ_LEVELS - 1;
+    enqueueReady(&demoted, 0);
+    enqueueReady(&arrival, 0);
+    CHECK(runQueues[0].headKey.load() == 0);
+
+    boostReadyQueues();
+    CHECK(demoted.queueLevel == 0);
+    CHECK(takeReady(0) == &demoted); // queued first, and now on the same level as the arrival
+    CHECK(takeReady(0) == &arrival);
+
+    enqueueReady(&running, 0); // was on a core during the boost
+    CHECK(running.queueLevel == 0);
+    CHECK(takeReady(0) == &running);
+
+    schedulerPolicy = std::move(saved);
+}
+
+// The sleep ticker only runs with a nonzero delay-per-exec, so normal runs never cascade the wheel
+void testTimerWheelCascade()
+{
+    TimerWheel wheel;
+    std::vector<uint64_t> expiries = {1, 2, 63, 64, 65, 127, 128, 129, 4095, 4096, 4097, 4160, 4161,
+                                      8191, 8192, 262143, 262144, 262145, 300000};
+    std::vector<ExecutableScreen> procs(expiries.size() + 3);
+    for (size_t i = 0; i < expiries.size(); ++i)
+        wheel.add(&procs[i], expiries[i]);
+
+    std::map<ExecutableScreen *, uint64_t> expected;
+    for (size_t i = 0; i < expiries.size(); ++i)
+        expected[&procs[i]] = expiries[i];
+
+    std::map<ExecutableScreen *, std::vector<uint64_t>> fired;
+    std::vector<ExecutableScreen *> due;
+    while (wheel.now < 300001)
+    {
+        if (wheel.now == 100) // added mid-run, so their deltas cross boundaries from an unaligned start
+        {
+            size_t base = expiries.size();
+            wheel.add(&procs[base], 100 + 28);
+            wheel.add(&procs[base + 1], 100 + 4000);
+            wheel.add(&procs[base + 2], 100 + 70000);
+            expected[&procs[base]] = 128;
+            expected[&procs[base + 1]] = 4100;
+            expected[&procs[base + 2]] = 70100;
+        }
+        due.clear();
+        wheel.advance(due);
+        for (ExecutableScreen *proc : due)
+            fired[proc].push_back(wheel.now);
+    }
+
+    CHECK(wheel.count == 0);
+    CHECK(fired.size() == expected.size());
+    for (const auto &[proc, tick] : expected)
+        CHECK(fired[proc].size() == 1 && fired[proc][0] == tick);
+}
+
+bool sameBlocks(const std::vector<MemoryBlock> &a, const std::vector<MemoryBlock> &b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i)
+        if (a[i].start != b[i].start || a[i].size != b[i].size || a[i].owner != b[i].owner)
+            return false;
+    return true;
+}
+
+// Freed buddies have to merge back up, including on memories that are not a power of two
+void testBuddyCoalescing()
+{
+    for (int total : {4096, 3072, 3000})
+    {
+        BuddyAllocator buddy(total);
+        std::vector<MemoryBlock> initial = buddy.blocks();
+        int covered = 0;
+        for (const MemoryBlock &block : initial)
+            covered += block.size;
+        CHECK(covered == total);
+
+        const std::vector<std::pair<std::string, int>> requests = {
+            {"a", 100}, {"b", 64}, {"c", 300}, {"d", 8}, {"e", 200}, {"f", 16}, {"g", 1}};
+        for (const auto &[owner, size] : requests)
+            CHECK(buddy.allocate(owner, size) >= 0);
+        CHECK(buddy.usedBytes == 128 + 64 + 512 + 8 + 256 + 16 + 1);
+
+        for (const char *owner : {"c", "a", "g", "e", "b", "f", "d"})
+            buddy.release(owner);
+        CHECK(buddy.usedBytes == 0 && buddy.requestedBytes == 0);
+        CHECK(sameBlocks(buddy.blocks(), initial));
+    }
+}
+
+int main()
+{
+    // The swap file goes to a scratch directory
+    std::filesystem::path workDir = std::filesystem::temp_directory_path() / "csopesy-tests";
+    std::filesystem::remove_all(workDir);
+    std::filesystem::create_directories(workDir);
+    std::filesystem::current_path(workDir);
+    output_dir = workDir.string();
+    logInstructions = false;
+    initializeMemorySystem();
+
+    testOutOfRangeLiterals();
+    testForRepeatCount();
+    testSnapshotSurvivesEviction();
+    testJsonEscape();
+    testStatusSlotsRecycled();
+    testShutdownNotCompactedEarly();
+    testMlfqBoost();
+    testTimerWheelCascade();
+    testBuddyCoalescing();
+
+    std::cout << (failures ? "FAILED: " : "All tests passed. ") << failures << " failed check(s).\n";
+    return failures;
+}